@@ -0,0 +1,85 @@
+/*
+   The arena allocator's implementation.
+
+   The blocks form a list. Allocations are taken from the current block,
+   moving on to the next one (or adding a new one) when it is full;
+   resetting simply starts again from the first block.
+*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include "Defines.h"
+#include "Arena.h"
+
+/* rounds the size up to the arena's alignment */
+#define ALIGNED(size) (((size) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+/* the allocations start this far into a block */
+#define HEADER_SIZE ALIGNED(sizeof(arenaBlock))
+
+void* arenaAlloc(arena* a, size_t size)
+{
+    arenaBlock *block = a->current;
+    void *memory;
+
+    size = ALIGNED(size);
+
+    /* move on to the following blocks, left over from before a reset */
+    while(block && block->used + size > block->size && block->next)
+    {
+        block = block->next;
+        block->used = 0;
+    }
+
+    if(!block || block->used + size > block->size)
+    {
+        arenaBlock *newBlock;
+        size_t blockSize = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+
+        /* safely allocate a new block */
+        if((newBlock = (arenaBlock*)malloc(HEADER_SIZE + blockSize)) == NULL)
+            yyerror("Out of memory encountered.");
+
+        assert(newBlock);
+        newBlock->size = blockSize;
+        newBlock->used = 0;
+
+        /* link it after the current block */
+        if(block)
+        {
+            newBlock->next = block->next;
+            block->next = newBlock;
+        }
+        else
+        {
+            newBlock->next = NULL;
+            a->first = newBlock;
+        }
+        block = newBlock;
+    }
+
+    a->current = block;
+    memory = (char*)block + HEADER_SIZE + block->used;
+    block->used += size;
+    return memory;
+}
+
+void arenaReset(arena* a)
+{
+    a->current = a->first;
+    if(a->first)
+        a->first->used = 0;
+}
+
+void arenaFree(arena* a)
+{
+    arenaBlock *block = a->first;
+
+    while(block)
+    {
+        arenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    a->first = a->current = NULL;
+}
@@ -0,0 +1,42 @@
+/*
+   Prototype functions for the arena (bump) allocator.
+
+   An arena hands out memory from large blocks by moving a pointer, and
+   takes it all back at once; nothing allocated from it is freed on its
+   own.
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/* every allocation is aligned to this many bytes */
+#define ARENA_ALIGN 16
+
+/* the usual size of a block */
+#define ARENA_BLOCK_SIZE 65536
+
+/* A block of memory; the allocations follow the header. */
+typedef struct arenaBlockTag {
+    struct arenaBlockTag *next;     /* the next block of the arena */
+    size_t size;                    /* bytes available in the block */
+    size_t used;                    /* bytes handed out so far */
+} arenaBlock;
+
+typedef struct {
+    arenaBlock *first;              /* the first block */
+    arenaBlock *current;            /* the block being allocated from */
+} arena;
+
+/* Allocates size bytes from the arena. */
+void* arenaAlloc(arena*, size_t);
+
+/* Takes back everything allocated from the arena; the blocks are kept
+   for the allocations that follow. */
+void arenaReset(arena*);
+
+/* Releases the blocks of the arena. */
+void arenaFree(arena*);
+
+#endif
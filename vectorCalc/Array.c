@@ -0,0 +1,361 @@
+/*
+   The array values' implementation.
+
+   The columns of an array are allocated on their own, so a temporary
+   can hand its columns over to a variable by swapping pointers. The
+   temporaries still alive are kept in a list: one an error leaves
+   behind is freed when the statement ends.
+*/
+
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include "Array.h"
+#include "Math.h"
+#include "vectorCalc.tab.h"
+
+/* functions prototypes */
+real* newColumn(int);
+void freeColumns(vectorArray*);
+
+/* the temporaries still alive */
+vectorArray *temporaryArrays = NULL;
+
+/* allocates a column of zeros */
+real* newColumn(int length)
+{
+    real *column;
+
+    /* safely allocate space, even for an empty array */
+    if((column = (real*)calloc(length ? length : 1, sizeof(real))) == NULL)
+        yyerror("Out of memory encountered when creating an array.");
+
+    assert(column);
+    return column;
+}
+
+void freeColumns(vectorArray* a)
+{
+    free(a->x);
+    free(a->y);
+    free(a->z);
+    a->x = a->y = a->z = NULL;
+    a->length = 0;
+}
+
+vectorArray* newArray(int type, int64 length)
+{
+    vectorArray *a;
+
+    if(length < 0 || length > INT_MAX)
+    {
+        yyerror("ERROR: invalid array size.");
+        length = 0;
+    }
+
+    /* safely allocate space */
+    if((a = (vectorArray*)calloc(1, sizeof(vectorArray))) == NULL)
+        yyerror("Out of memory encountered when creating an array.");
+
+    assert(a);
+    a->type = type;
+    a->length = (int)length;
+    a->x = newColumn(a->length);
+    if(type == typeVecArray)
+    {
+        a->y = newColumn(a->length);
+        a->z = newColumn(a->length);
+    }
+
+    a->temporary = 1;
+    a->next = temporaryArrays;
+    if(temporaryArrays)
+        temporaryArrays->previous = a;
+    temporaryArrays = a;
+    return a;
+}
+
+int elementType(int type)
+{
+    return type == typeVecArray ? typeVecConstant : typeNumConstant;
+}
+
+int arrayOperatorType(int oper, int t1, int t2)
+{
+    int vec = typeVecConstant, num = typeNumConstant;
+    /* an array operand works as its elements would, one by one, and any
+       other operand is used with every element */
+    int e1 = IS_ARRAY(t1) ? elementType(t1) : t1;
+    int e2 = IS_ARRAY(t2) ? elementType(t2) : t2;
+    int element = -1;
+
+    if(oper == UMINUS)
+        return IS_ARRAY(t1) ? t1 : -1;
+    if(!IS_ARRAY(t1) && !IS_ARRAY(t2))
+        return -1;
+    if((e1 != vec && e1 != num) || (e2 != vec && e2 != num))
+        return -1;
+
+    switch(oper)
+    {
+        case '+':
+        case '-':
+            element = e1 == e2 ? e1 : -1;
+            break;
+
+        case '*':
+        case '/':
+            /* a vector is scaled by (or divided by) a number on either
+               side, as a single one is */
+            if(e1 == num)
+                element = e2;
+            else if(e2 == num)
+                element = e1;
+            break;
+
+        case CROSS:
+        case DOT:
+            if(e1 == vec && e2 == vec)
+                element = oper == CROSS ? vec : num;
+            break;
+
+        case EQ:
+        case NE:
+            /* compared element by element, see compareArrays() */
+            return IS_ARRAY(t1) && t1 == t2 ? typeBool : -1;
+    }
+
+    if(element == -1)
+        return -1;
+    return element == vec ? typeVecArray : typeNumArray;
+}
+
+vectorArray* arrayOperator(int oper, int t1, void* op1, int t2, void* op2)
+{
+    vectorArray *a = IS_ARRAY(t1) ? *(vectorArray**)op1 : NULL;
+    vectorArray *b = IS_ARRAY(t2) && oper != UMINUS ? *(vectorArray**)op2 : NULL;
+    vectorArray *result = NULL;
+    int type = arrayOperatorType(oper, t1, t2);
+
+    if(type == -1)
+        yyerror("Incompatible types: operation can't be performed on arrays.");
+    else if(a && b && a->length != b->length)
+        yyerror("ERROR: arrays of different lengths.");
+    else
+    {
+        /* a temporary operand of the same type takes the result, so
+           nothing is allocated */
+        if(a && a->temporary && a->type == type)
+            result = a;
+        else if(b && b->temporary && b->type == type)
+            result = b;
+        else
+            result = newArray(type, (a ? a : b)->length);
+
+        switch(oper)
+        {
+            case UMINUS:
+                arrayNeg(a, result);
+                break;
+
+            case '+':
+                if(a && b)              arrayAdd(a, b, result);
+                else if(type == typeNumArray)
+                    arrayAddNumber(a ? a : b, *(real*)(a ? op2 : op1), result);
+                else if(a)              arrayAddVector(a, (vector3*)op2, result);
+                else                    arrayAddVector(b, (vector3*)op1, result);
+                break;
+
+            case '-':
+                if(a && b)              arraySub(a, b, result);
+                else if(type == typeNumArray && a)
+                    arraySubNumber(a, *(real*)op2, result);
+                else if(type == typeNumArray)
+                    numberSubArray(*(real*)op1, b, result);
+                else if(a)              arraySubVector(a, (vector3*)op2, result);
+                else                    vectorSubArray((vector3*)op1, b, result);
+                break;
+
+            case '*':
+                /* the numbers are the second array, if there are two */
+                if(a && b && b->type == typeNumArray)
+                    arrayMulArray(a, b, result);
+                else if(a && b)         arrayMulArray(b, a, result);
+                else if(a && t2 == typeNumConstant)
+                    arrayScale(a, *(real*)op2, result);
+                else if(a)              vectorMulArray((vector3*)op2, a, result);
+                else if(t1 == typeNumConstant)
+                    arrayScale(b, *(real*)op1, result);
+                else                    vectorMulArray((vector3*)op1, b, result);
+                break;
+
+            case '/':
+                /* the vectors are divided by the numbers, whichever side
+                   they are on - by scaling them by the reciprocal, just
+                   like a single vector; only numbers by numbers are
+                   divided in order */
+                if(a && b && type == typeNumArray)
+                    arrayDivArray(a, b, result);
+                else if(a && b)
+                    arrayDivArray(a->type == typeVecArray ? a : b,
+                                  a->type == typeVecArray ? b : a, result);
+                else if(type == typeNumArray && a)
+                    arrayDivNumber(a, *(real*)op2, result);
+                else if(type == typeNumArray)
+                    numberDivArray(*(real*)op1, b, result);
+                else if(a && t2 == typeNumConstant)
+                    arrayScale(a, 1 / *(real*)op2, result);
+                else if(a)              vectorDivArray((vector3*)op2, a, result);
+                else if(t1 == typeNumConstant)
+                    arrayScale(b, 1 / *(real*)op1, result);
+                else                    vectorDivArray((vector3*)op1, b, result);
+                break;
+
+            case CROSS:
+                if(a && b)  arrayCross(a, b, result);
+                else if(a)  arrayCrossVector(a, (vector3*)op2, result);
+                else        vectorCrossArray((vector3*)op1, b, result);
+                break;
+
+            case DOT:
+                if(a && b)  arrayDot(a, b, result);
+                else        arrayDotVector(a ? a : b, (vector3*)(a ? op2 : op1), result);
+                break;
+        }
+    }
+
+    /* the operands are used up */
+    if(a != result)
+        releaseArray(a);
+    if(b != result)
+        releaseArray(b);
+    return result;
+}
+
+int compareArrays(vectorArray* a, vectorArray* b)
+{
+    int equal = a->length == b->length && arrayCompare(a, b);
+
+    releaseArray(a);
+    if(b != a)
+        releaseArray(b);
+    return equal;
+}
+
+int getElement(vectorArray* a, int64 index, void* value)
+{
+    int inRange = index >= 0 && index < a->length;
+    int i = inRange ? (int)index : 0;
+
+    if(!inRange)
+        yyerror("ERROR: array index out of range.");
+
+    if(a->type == typeVecArray)
+    {
+        vector3 *vector = (vector3*)value;
+        vector->x = inRange ? a->x[i] : 0;
+        vector->y = inRange ? a->y[i] : 0;
+        vector->z = inRange ? a->z[i] : 0;
+    }
+    else
+        *(real*)value = inRange ? a->x[i] : 0;
+    return inRange;
+}
+
+int setElement(vectorArray* a, int64 index, void* value)
+{
+    int i;
+
+    if(index < 0 || index >= a->length)
+    {
+        yyerror("ERROR: array index out of range.");
+        return 0;
+    }
+
+    i = (int)index;
+    if(a->type == typeVecArray)
+    {
+        vector3 *vector = (vector3*)value;
+        a->x[i] = vector->x;
+        a->y[i] = vector->y;
+        a->z[i] = vector->z;
+    }
+    else
+        a->x[i] = *(real*)value;
+    return 1;
+}
+
+void assignArray(vectorArray* variable, vectorArray* value)
+{
+    vectorArray old;
+
+    if(variable == value)
+        return;
+
+    if(value->temporary)
+    {
+        /* take the columns over; the temporary frees the old ones */
+        old = *variable;
+        variable->length = value->length;
+        variable->x = value->x;
+        variable->y = value->y;
+        variable->z = value->z;
+        value->length = old.length;
+        value->x = old.x;
+        value->y = old.y;
+        value->z = old.z;
+        releaseArray(value);
+        return;
+    }
+
+    /* another variable's array is copied, never aliased */
+    freeColumns(variable);
+    variable->length = value->length;
+    variable->x = newColumn(value->length);
+    memcpy(variable->x, value->x, value->length * sizeof(real));
+    if(value->type == typeVecArray)
+    {
+        variable->y = newColumn(value->length);
+        variable->z = newColumn(value->length);
+        memcpy(variable->y, value->y, value->length * sizeof(real));
+        memcpy(variable->z, value->z, value->length * sizeof(real));
+    }
+}
+
+int printArray(FILE* file, vectorArray* a)
+{
+    int i;
+
+    fprintf(file, "[");
+    for(i = 0; i < a->length; ++i)
+    {
+        if(a->type == typeVecArray)
+            fprintf(file, "%s" VECTOR_FORMAT, i ? ", " : "",
+                    a->x[i], a->y[i], a->z[i]);
+        else
+            fprintf(file, "%s" NUMBER_FORMAT, i ? ", " : "", a->x[i]);
+    }
+    return fprintf(file, "]\n");
+}
+
+void releaseArray(vectorArray* a)
+{
+    if(!a || !a->temporary)
+        return;
+
+    if(a->previous)
+        a->previous->next = a->next;
+    else
+        temporaryArrays = a->next;
+    if(a->next)
+        a->next->previous = a->previous;
+
+    freeColumns(a);
+    free(a);
+}
+
+void freeTemporaryArrays(void)
+{
+    while(temporaryArrays)
+        releaseArray(temporaryArrays);
+}
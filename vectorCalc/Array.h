@@ -0,0 +1,68 @@
+/*
+   Prototype functions for the array values - vector[] and number[] -
+   and the whole-array operators.
+
+   An array held by a variable lives in its symbol table entry. Every
+   other array is a temporary, the result of an operator: it is used by
+   exactly one operator, which frees it (or takes it over for its own
+   result) once it is done with it.
+*/
+
+#ifndef ARRAY_H
+#define ARRAY_H
+
+#include <stdio.h>
+#include "ParseTree.h"
+
+/* true for the types of the array values */
+#define IS_ARRAY(type) ((type) == typeVecArray || (type) == typeNumArray)
+
+/* Creates a temporary array of the type (typeVecArray or typeNumArray)
+   with every element zero; a size out of range is reported, and gives
+   an empty array. */
+vectorArray* newArray(int, int64);
+
+/* The type of the elements of an array type. */
+int elementType(int);
+
+/* The type of the result of a whole-array operator ('+', '-', '*', '/',
+   CROSS, DOT, EQ, NE or UMINUS) for the types of its operands (the one
+   operand twice for unary minus), or -1 if they are wrong. */
+int arrayOperatorType(int, int, int);
+
+/* Applies a whole-array operator to the operands, given by their types
+   and pointers to their values (a vectorArray*, a vector3 or a real).
+   The temporaries among them are used up. Returns the resulting
+   temporary, or NULL once an error has been reported. */
+vectorArray* arrayOperator(int, int, void*, int, void*);
+
+/* True if the arrays have the same length and their elements compare
+   equal one by one; the temporaries among them are used up. EQ and NE
+   are left out of arrayOperator(), as they give a bool. */
+int compareArrays(vectorArray*, vectorArray*);
+
+/* Copies the element at the index into the vector3 or real value
+   points at; an index out of range is reported, gives a zero element
+   and returns false. */
+int getElement(vectorArray*, int64, void*);
+
+/* Sets the element at the index to the vector3 or real value points
+   at; returns false if the index is out of range. */
+int setElement(vectorArray*, int64, void*);
+
+/* Gives the variable's array the elements of the value, using it up: a
+   temporary hands its elements over without them being copied. */
+void assignArray(vectorArray*, vectorArray*);
+
+/* Prints the elements of the array on one line. */
+int printArray(FILE*, vectorArray*);
+
+/* Frees the array if it is a temporary; the arrays of variables are
+   left alone. */
+void releaseArray(vectorArray*);
+
+/* Frees the temporaries an error left behind; called after every
+   statement. */
+void freeTemporaryArrays(void);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+/*
+ * The bytecode is a flat stream of instructions for a simple stack
+ * machine. Every statement of the parse tree is lowered into one chunk,
+ * which holds the instructions together with the constants and variable
+ * names they refer to. Control statements become plain jumps, so loops
+ * are run without walking (or re-dispatching on) the tree.
+ *
+ */
+
+#include "Defines.h"
+
+/* All the instructions are enumerated. */
+typedef enum {
+    opPushNumber,               /* push numbers[arg] */
+    opPushVector,               /* push vectors[arg] */
+    opPushInteger,              /* push integers[arg] */
+    opPushVec2,                 /* push vectors2[arg] */
+    opPushVec4,                 /* push vectors4[arg] */
+    opLoad,                     /* push the value of names[arg] */
+    opStore,                    /* pop a value into names[arg], push the flag */
+    opPop,                      /* discard the top of the stack */
+    opNegate,                   /* unary minus */
+    opToNumber,                 /* turn the int on top into a number */
+    opNewArray,                 /* pop the size, push a new array; arg is
+                                   its type */
+    opIndex,                    /* pop the index, push that element of
+                                   names[arg] */
+    opStoreIndex,               /* pop a value and an index into that
+                                   element of names[arg], push the flag */
+    opAdd,
+    opSub,
+    opMul,
+    opDiv,
+    opCross,
+    opDot,
+    opLess,
+    opGreater,
+    opGreaterEqual,
+    opLessEqual,
+    opNotEqual,
+    opEqual,
+    opPrint,                    /* pop and print; arg is names index or -1 */
+    opLine,                     /* a kept statement starts; arg is its line */
+    opJump,                     /* jump to arg */
+    opJumpIfFalse,              /* pop the condition, jump to arg if false */
+    opJumpIfTrue,               /* pop the condition, jump to arg if true */
+    opHalt                      /* end of the chunk */
+} opcodeEnum;
+
+/* a single instruction */
+typedef struct {
+    int opcode;                 /* one of opcodeEnum */
+    int arg;                    /* operand - index or jump target */
+} instruction;
+
+/* a variable referenced by the chunk */
+typedef struct {
+    char* name;                 /* id string, for printing */
+    int type;                   /* the type of the id */
+    struct symbolNode* symbol;  /* its symbol table entry, or NULL */
+} chunkName;
+
+/* a compiled statement */
+typedef struct {
+    instruction* code;          /* instruction stream */
+    int codeCount, codeCapacity;
+    real* numbers;              /* numeric constants */
+    int numberCount, numberCapacity;
+    vector3* vectors;           /* vector constants, copied by value */
+    int vectorCount, vectorCapacity;
+    vec2* vectors2;             /* vec2 constants */
+    int vector2Count, vector2Capacity;
+    vec4* vectors4;             /* vec4 constants */
+    int vector4Count, vector4Capacity;
+    int64* integers;            /* int constants */
+    int integerCount, integerCapacity;
+    chunkName* names;           /* variables */
+    int nameCount, nameCapacity;
+    int depth;                  /* stack depth while compiling */
+    int maxDepth;               /* stack size the chunk needs */
+} chunk;
+
+#endif
@@ -0,0 +1,362 @@
+/*
+   The bytecode compiler's implementation.
+
+   The parse tree of a statement is traversed once, in the same
+   Depth-First order the interpreter uses, and every node is lowered into
+   instructions for the stack machine. Expressions leave exactly one value
+   on the stack; statements leave the stack as they found it.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "BytecodeCompiler.h"
+#include "vectorCalc.tab.h"
+
+/* functions prototypes */
+void* growArray(void*, int*, size_t);
+int emitInstruction(chunk*, int, int);
+int addNumber(chunk*, real);
+int addVector(chunk*, vector3*);
+int addVec2(chunk*, vec2*);
+int addVec4(chunk*, vec4*);
+int addInteger(chunk*, int64);
+int addName(chunk*, nodeType*);
+int compileNode(chunk*, nodeType*);
+void compileStatement(chunk*, nodeType*);
+
+/* doubles the capacity of an array once it is full */
+void* growArray(void* array, int* capacity, size_t size)
+{
+    *capacity = *capacity ? *capacity * 2 : 8;
+
+    /* safely reallocate space */
+    if((array = realloc(array, *capacity * size)) == NULL)
+        yyerror("Out of memory encountered.");
+
+    assert(array);
+    return array;
+}
+
+/* appends an instruction and returns its position in the chunk */
+int emitInstruction(chunk* c, int opcode, int arg)
+{
+    if(c->codeCount == c->codeCapacity)
+        c->code = growArray(c->code, &c->codeCapacity, sizeof(instruction));
+
+    c->code[c->codeCount].opcode = opcode;
+    c->code[c->codeCount].arg = arg;
+
+    /* keep track of how deep the stack can grow */
+    switch(opcode)
+    {
+        case opPushNumber:
+        case opPushVector:
+        case opPushInteger:
+        case opPushVec2:
+        case opPushVec4:
+        case opLoad:
+            c->depth++;
+            break;
+        case opPop:
+        case opAdd: case opSub: case opMul: case opDiv:
+        case opCross: case opDot:
+        case opLess: case opGreater: case opGreaterEqual:
+        case opLessEqual: case opNotEqual: case opEqual:
+        case opPrint:
+        case opStoreIndex:
+        case opJumpIfFalse:
+        case opJumpIfTrue:
+            c->depth--;
+            break;
+    }
+    if(c->depth > c->maxDepth)
+        c->maxDepth = c->depth;
+
+    return c->codeCount++;
+}
+
+int addNumber(chunk* c, real number)
+{
+    if(c->numberCount == c->numberCapacity)
+        c->numbers = growArray(c->numbers, &c->numberCapacity, sizeof(real));
+
+    c->numbers[c->numberCount] = number;
+    return c->numberCount++;
+}
+
+int addVector(chunk* c, vector3* vector)
+{
+    if(c->vectorCount == c->vectorCapacity)
+        c->vectors = growArray(c->vectors, &c->vectorCapacity, sizeof(vector3));
+
+    /* copy the constant, so the chunk doesn't depend on the tree */
+    c->vectors[c->vectorCount] = *vector;
+    return c->vectorCount++;
+}
+
+int addVec2(chunk* c, vec2* vector)
+{
+    if(c->vector2Count == c->vector2Capacity)
+        c->vectors2 = growArray(c->vectors2, &c->vector2Capacity, sizeof(vec2));
+
+    c->vectors2[c->vector2Count] = *vector;
+    return c->vector2Count++;
+}
+
+int addVec4(chunk* c, vec4* vector)
+{
+    if(c->vector4Count == c->vector4Capacity)
+        c->vectors4 = growArray(c->vectors4, &c->vector4Capacity, sizeof(vec4));
+
+    c->vectors4[c->vector4Count] = *vector;
+    return c->vector4Count++;
+}
+
+int addInteger(chunk* c, int64 integer)
+{
+    if(c->integerCount == c->integerCapacity)
+        c->integers = growArray(c->integers, &c->integerCapacity, sizeof(int64));
+
+    c->integers[c->integerCount] = integer;
+    return c->integerCount++;
+}
+
+/* returns the index of the variable, adding it on the first reference */
+int addName(chunk* c, nodeType* p)
+{
+    int i;
+
+    /* undeclared names have no entry, and are told apart by name */
+    for(i = 0; i < c->nameCount; ++i)
+        if(c->names[i].type == p->id.idType && c->names[i].symbol == p->id.symbol &&
+           (p->id.symbol || !strcmp(c->names[i].name, p->id.id)))
+            return i;
+
+    if(c->nameCount == c->nameCapacity)
+        c->names = growArray(c->names, &c->nameCapacity, sizeof(chunkName));
+
+    c->names[c->nameCount].name = p->id.id;
+    c->names[c->nameCount].type = p->id.idType;
+    c->names[c->nameCount].symbol = p->id.symbol;
+    return c->nameCount++;
+}
+
+/* compiles the node and returns the number of values it pushed */
+int compileNode(chunk* c, nodeType* p)
+{
+    /* if we're given NULL - there is nothing to compile */
+    if(!p) return 0;
+
+    switch(p->type)
+    {
+        case typeNumConstant:
+            emitInstruction(c, opPushNumber, addNumber(c, p->con.data.number));
+            return 1;
+
+        case typeVecConstant:
+            emitInstruction(c, opPushVector, addVector(c, &p->con.data.vector));
+            return 1;
+
+        case typeIntConstant:
+            emitInstruction(c, opPushInteger, addInteger(c, p->con.data.integer));
+            return 1;
+
+        case typeVec2Constant:
+            emitInstruction(c, opPushVec2, addVec2(c, &p->con.data.vector2));
+            return 1;
+
+        case typeVec4Constant:
+            emitInstruction(c, opPushVec4, addVec4(c, &p->con.data.vector4));
+            return 1;
+
+        case typeBool:
+            /* bools are only ever produced by the operators, there are
+               no bool constants */
+            break;
+
+        case typeVecArray:
+        case typeNumArray:
+            /* arrays are only ever created by VEC_ARRAY and NUM_ARRAY,
+               there are no array constants */
+            break;
+
+        case typeId:
+            emitInstruction(c, opLoad, addName(c, p));
+            return 1;
+
+        case typeOperator:
+        {
+            switch(p->opr.oper)
+            {
+                case WHILE:
+                {
+                    /* the condition is re-evaluated before each pass of the
+                       body, exactly as interpret() does */
+                    int done, loop;
+
+                    compileNode(c, p->opr.op[0]);
+                    done = emitInstruction(c, opJumpIfFalse, 0);
+                    loop = c->codeCount;
+                    compileNode(c, p->opr.op[0]);
+                    compileStatement(c, p->opr.op[1]);
+                    emitInstruction(c, opJumpIfTrue, loop);
+                    c->code[done].arg = c->codeCount;
+                    return 0;
+                }
+
+                case IF:
+                {
+                    int otherwise, end;
+
+                    compileNode(c, p->opr.op[0]);
+                    otherwise = emitInstruction(c, opJumpIfFalse, 0);
+                    compileStatement(c, p->opr.op[1]);
+
+                    /* this can be an if-else */
+                    if(p->opr.nops > 2)
+                    {
+                        end = emitInstruction(c, opJump, 0);
+                        c->code[otherwise].arg = c->codeCount;
+                        compileStatement(c, p->opr.op[2]);
+                        c->code[end].arg = c->codeCount;
+                    }
+                    else
+                        c->code[otherwise].arg = c->codeCount;
+                    return 0;
+                }
+
+                case PRINT:
+                {
+                    nodeType *toPrint = p->opr.op[0];
+
+                    compileNode(c, toPrint);
+                    /* variables are printed together with their names */
+                    if(toPrint->type == typeId)
+                        emitInstruction(c, opPrint,
+                                        addName(c, toPrint));
+                    else
+                        emitInstruction(c, opPrint, -1);
+                    return 0;
+                }
+
+                case ';':
+                    compileStatement(c, p->opr.op[0]);
+                    compileStatement(c, p->opr.op[1]);
+                    return 0;
+
+                case SEQUENCE:
+                {
+                    int i;
+
+                    for(i = 0; i < p->opr.nops; ++i)
+                        compileStatement(c, p->opr.op[i]);
+                    return 0;
+                }
+
+                case '=':
+                {
+                    nodeType *lhs = p->opr.op[0];
+
+                    compileNode(c, p->opr.op[1]);
+                    emitInstruction(c, opStore, addName(c, lhs));
+                    return 1;
+                }
+
+                case UMINUS:
+                    compileNode(c, p->opr.op[0]);
+                    emitInstruction(c, opNegate, 0);
+                    return 1;
+
+                case TO_NUMBER:
+                    compileNode(c, p->opr.op[0]);
+                    emitInstruction(c, opToNumber, 0);
+                    return 1;
+
+                case VEC_ARRAY:
+                case NUM_ARRAY:
+                    compileNode(c, p->opr.op[0]);
+                    emitInstruction(c, opNewArray, p->opr.oper == VEC_ARRAY ?
+                                                   typeVecArray : typeNumArray);
+                    return 1;
+
+                case INDEX:
+                    compileNode(c, p->opr.op[1]);
+                    emitInstruction(c, opIndex, addName(c, p->opr.op[0]));
+                    return 1;
+
+                case INDEX_ASSIGN:
+                    compileNode(c, p->opr.op[1]);
+                    compileNode(c, p->opr.op[2]);
+                    emitInstruction(c, opStoreIndex, addName(c, p->opr.op[0]));
+                    return 1;
+            }
+
+            /* the rest are binary operators */
+            compileNode(c, p->opr.op[0]);
+            compileNode(c, p->opr.op[1]);
+
+            switch(p->opr.oper)
+            {
+                case '+':   emitInstruction(c, opAdd, 0); break;
+                case '-':   emitInstruction(c, opSub, 0); break;
+                case '*':   emitInstruction(c, opMul, 0); break;
+                case '/':   emitInstruction(c, opDiv, 0); break;
+                case CROSS: emitInstruction(c, opCross, 0); break;
+                case DOT:   emitInstruction(c, opDot, 0); break;
+                case '<':   emitInstruction(c, opLess, 0); break;
+                case '>':   emitInstruction(c, opGreater, 0); break;
+                case GE:    emitInstruction(c, opGreaterEqual, 0); break;
+                case LE:    emitInstruction(c, opLessEqual, 0); break;
+                case NE:    emitInstruction(c, opNotEqual, 0); break;
+                case EQ:    emitInstruction(c, opEqual, 0); break;
+                default:    assert(!"Compiling didn't match any rules");
+            }
+            return 1;
+        }
+    }
+    assert(!"Compiling didn't match any rules");
+    return 0;
+}
+
+/* compiles the node, discarding its value if it has one */
+void compileStatement(chunk* c, nodeType* p)
+{
+    /* a kept statement first makes its line the current one */
+    if(p && p->type == typeOperator && p->opr.line)
+        emitInstruction(c, opLine, p->opr.line);
+
+    if(compileNode(c, p))
+        emitInstruction(c, opPop, 0);
+}
+
+chunk* compileTree(nodeType* p)
+{
+    chunk *c;
+
+    /* safely allocate space */
+    if((c = (chunk*)calloc(1, sizeof(chunk))) == NULL)
+        yyerror("Out of memory encountered.");
+
+    assert(c);
+    compileStatement(c, p);
+    emitInstruction(c, opHalt, 0);
+
+    assert(c->depth == 0);
+    return c;
+}
+
+void freeChunk(chunk* c)
+{
+    /* check if the chunk is free already; if yes - return */
+    if(!c) return;
+
+    free(c->code);
+    free(c->numbers);
+    free(c->vectors);
+    free(c->vectors2);
+    free(c->vectors4);
+    free(c->integers);
+    free(c->names);
+    free(c);
+}
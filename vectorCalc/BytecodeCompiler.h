@@ -0,0 +1,11 @@
+/*
+   Prototype functions for the bytecode compiler.
+*/
+
+#include "ParseTree.h"
+#include "Bytecode.h"
+
+/* Lowers the parse tree of a single statement into a new chunk. */
+chunk* compileTree(nodeType*);
+
+void freeChunk(chunk*);
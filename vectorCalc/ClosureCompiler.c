@@ -0,0 +1,1014 @@
+/*
+   The closure compiler's implementation.
+
+   Every node of the parse tree is turned into a closure - a pointer to
+   the handler that implements it, together with the operands the handler
+   works on (constants, variable names and the closures of the
+   sub-expressions). The handler is chosen once, while compiling; whenever
+   the types of the operands are already known, a handler specialised for
+   them is picked, so running a statement never goes through the big
+   switch of interpret() and mostly skips the type checks, too.
+*/
+
+#include <stdio.h>
+#include <assert.h>
+#include "ClosureCompiler.h"
+#include "SymbolTable.h"
+#include "vectorCalc.tab.h"
+#include "Math.h"
+#include "Array.h"
+#include "VectorN.h"
+
+/* a value produced by a closure */
+typedef struct {
+    int type;                       /* simple typing */
+    union {
+        vector3 vector;             /* vector values */
+        vec2 vector2;               /* vec2 values */
+        vec4 vector4;               /* vec4 values */
+        real number;                /* numeric values */
+        int64 integer;              /* int values */
+        vectorArray* array;         /* array values */
+        int bool;                   /* true/false values */
+    } data;
+} closureValue;
+
+typedef void (*closureHandler)(closure*, closureValue*);
+
+struct closureTag {
+    closureHandler handler;         /* implementation of the node */
+    int type;                       /* type of the result; -1 if not known */
+    int oper;                       /* operator, for the generic handler */
+    closureValue constant;          /* bound constant */
+    char* name;                     /* name of the printed variable */
+    symbolEntry* symbol;            /* bound variable */
+    int nops;                       /* number of operands */
+    closure* op[3];                 /* bound operands */
+};
+
+/* The output file defined in main.c */
+extern FILE *dataFile;
+
+/* number of errors detected - defined in vectorCalc.y */
+extern int errorCount;
+
+/* the current line - defined in vectorCalc.l */
+extern int yylinenum;
+
+/* the number of errors when the closure started running; a statement
+   stops at the first error of its own */
+int closureErrors = 0;
+
+/* functions prototypes */
+closure* newClosure(closureHandler, int);
+closureHandler specialiseOperator(int, int, int, int*);
+closure* compileClosureNode(nodeType*);
+closure* compileClosureSequence(nodeType**, int);
+int applyOperator(int, closureValue*, closureValue*, closureValue*);
+
+/* handlers of the constants and the variables */
+void closureConstant(closure* c, closureValue* out)
+{
+    *out = c->constant;
+}
+
+void closureLoadNumber(closure* c, closureValue* out)
+{
+    out->type = typeNumConstant;
+    if(c->symbol)
+        out->data.number = c->symbol->data.number;
+}
+
+void closureLoadVector(closure* c, closureValue* out)
+{
+    out->type = typeVecConstant;
+    if(c->symbol)
+        out->data.vector = c->symbol->data.vector;
+}
+
+void closureLoadInteger(closure* c, closureValue* out)
+{
+    out->type = typeIntConstant;
+    if(c->symbol)
+        out->data.integer = c->symbol->data.integer;
+}
+
+void closureLoadVec2(closure* c, closureValue* out)
+{
+    out->type = typeVec2Constant;
+    if(c->symbol)
+        out->data.vector2 = c->symbol->data.vector2;
+}
+
+void closureLoadVec4(closure* c, closureValue* out)
+{
+    out->type = typeVec4Constant;
+    if(c->symbol)
+        out->data.vector4 = c->symbol->data.vector4;
+}
+
+void closureLoadArray(closure* c, closureValue* out)
+{
+    out->type = c->type;
+    if(c->symbol)
+        out->data.array = &c->symbol->data.array;
+}
+
+/* handlers of the arrays; the type of a new array is kept as the constant's */
+void closureNewArray(closure* c, closureValue* out)
+{
+    closureValue size;
+
+    c->op[0]->handler(c->op[0], &size);
+    out->type = c->constant.type;
+    out->data.array = newArray(c->constant.type, size.data.integer);
+}
+
+void closureIndex(closure* c, closureValue* out)
+{
+    closureValue index;
+
+    c->op[0]->handler(c->op[0], &index);
+    out->type = c->type;
+    getElement(&c->symbol->data.array, index.data.integer, &(out->data));
+}
+
+void closureStoreIndex(closure* c, closureValue* out)
+{
+    closureValue index, value;
+
+    c->op[0]->handler(c->op[0], &index);
+    c->op[1]->handler(c->op[1], &value);
+    out->type = typeBool;
+    out->data.bool = setElement(&c->symbol->data.array, index.data.integer, &(value.data));
+}
+
+/* handlers of the statements */
+void closureStore(closure* c, closureValue* out)
+{
+    closureValue rhs;
+    symbolEntry *symbol = c->symbol;
+    int stored = 0;
+
+    c->op[0]->handler(c->op[0], &rhs);
+    if(errorCount != closureErrors) return;
+
+    /* Very simple type-checking */
+    if(symbol && c->constant.type != rhs.type)
+    {
+        yyerror("ERROR: Incompatible types to assign.");
+        return;
+    }
+
+    if(symbol)
+        switch(rhs.type)
+        {
+            case typeVecConstant:
+                /* the vector is copied into the variable */
+                symbol->data.vector = rhs.data.vector;
+                stored = 1;
+                break;
+            case typeNumConstant:
+                symbol->data.number = rhs.data.number;
+                stored = 1;
+                break;
+            case typeIntConstant:
+                symbol->data.integer = rhs.data.integer;
+                stored = 1;
+                break;
+            case typeVec2Constant:
+                symbol->data.vector2 = rhs.data.vector2;
+                stored = 1;
+                break;
+            case typeVec4Constant:
+                symbol->data.vector4 = rhs.data.vector4;
+                stored = 1;
+                break;
+            case typeVecArray:
+            case typeNumArray:
+                assignArray(&symbol->data.array, rhs.data.array);
+                stored = 1;
+                break;
+        }
+    out->type = typeBool;
+    out->data.bool = stored;
+}
+
+void closureSequence(closure* c, closureValue* out)
+{
+    c->op[0]->handler(c->op[0], out);
+    if(errorCount != closureErrors) return;
+    c->op[1]->handler(c->op[1], out);
+}
+
+/* a kept statement; its line is kept as the constant */
+void closureLine(closure* c, closureValue* out)
+{
+    yylinenum = (int)c->constant.data.integer;
+    c->op[0]->handler(c->op[0], out);
+}
+
+void closureNothing(closure* c, closureValue* out)
+{
+    (void)c;
+    out->type = typeBool;
+    out->data.bool = 0;
+}
+
+void closureWhile(closure* c, closureValue* out)
+{
+    closureValue condition;
+
+    c->op[0]->handler(c->op[0], &condition);
+    /* while the condition holds, re-evaluate it and run the body -
+       in the same order as interpret() does */
+    while(errorCount == closureErrors)
+    {
+        if(condition.type != typeBool)
+        {
+            yyerror("WHILE failed, the condition is not of type BOOL.");
+            return;
+        }
+        if(!condition.data.bool)
+            break;
+        c->op[0]->handler(c->op[0], &condition);
+        c->op[1]->handler(c->op[1], out);
+    }
+    out->type = typeBool;
+    out->data.bool = 0;
+}
+
+void closureIf(closure* c, closureValue* out)
+{
+    closureValue condition;
+
+    c->op[0]->handler(c->op[0], &condition);
+    if(errorCount != closureErrors) return;
+    if(condition.type != typeBool)
+    {
+        yyerror("IF failed, the condition is not of type BOOL.");
+        return;
+    }
+
+    if(condition.data.bool)
+        c->op[1]->handler(c->op[1], out);
+    /* this can be an if-else */
+    else if(c->nops > 2)
+        c->op[2]->handler(c->op[2], out);
+
+    out->type = typeBool;
+    out->data.bool = 0;
+}
+
+void closurePrint(closure* c, closureValue* out)
+{
+    closureValue toPrint;
+
+    c->op[0]->handler(c->op[0], &toPrint);
+    if(errorCount != closureErrors) return;
+
+    if(c->name)
+        fprintf(dataFile, "%s = ", c->name);
+
+    switch(toPrint.type)
+    {
+        case typeVecConstant:
+            fprintf(dataFile, VECTOR_FORMAT "\n",
+                    toPrint.data.vector.x,
+                    toPrint.data.vector.y,
+                    toPrint.data.vector.z);
+            break;
+        case typeNumConstant:
+            fprintf(dataFile, NUMBER_FORMAT "\n", toPrint.data.number);
+            break;
+        case typeIntConstant:
+            fprintf(dataFile, INT64_FORMAT "\n", toPrint.data.integer);
+            break;
+        case typeVecArray:
+        case typeNumArray:
+            printArray(dataFile, toPrint.data.array);
+            releaseArray(toPrint.data.array);
+            break;
+        case typeVec2Constant:
+        case typeVec4Constant:
+            printVectorN(dataFile, toPrint.type, &(toPrint.data));
+            break;
+        default:
+            yyerror("Wrong argument for printing.");
+    }
+    out->type = typeBool;
+    out->data.bool = 0;
+}
+
+/* handlers specialised for the types of their operands */
+void closureNumNegate(closure* c, closureValue* out)
+{
+    c->op[0]->handler(c->op[0], out);
+    out->data.number = -out->data.number;
+}
+
+void closureVecNegate(closure* c, closureValue* out)
+{
+    c->op[0]->handler(c->op[0], out);
+    vectorNeg(&(out->data.vector), &(out->data.vector));
+}
+
+void closureNumAdd(closure* c, closureValue* out)
+{
+    closureValue b;
+    c->op[0]->handler(c->op[0], out);
+    c->op[1]->handler(c->op[1], &b);
+    out->data.number += b.data.number;
+}
+
+void closureVecAdd(closure* c, closureValue* out)
+{
+    closureValue b;
+    c->op[0]->handler(c->op[0], out);
+    c->op[1]->handler(c->op[1], &b);
+    vectorAdd(&(out->data.vector), &(b.data.vector), &(out->data.vector));
+}
+
+void closureNumSub(closure* c, closureValue* out)
+{
+    closureValue b;
+    c->op[0]->handler(c->op[0], out);
+    c->op[1]->handler(c->op[1], &b);
+    out->data.number -= b.data.number;
+}
+
+void closureVecSub(closure* c, closureValue* out)
+{
+    closureValue b;
+    c->op[0]->handler(c->op[0], out);
+    c->op[1]->handler(c->op[1], &b);
+    vectorSub(&(out->data.vector), &(b.data.vector), &(out->data.vector));
+}
+
+void closureNumMul(closure* c, closureValue* out)
+{
+    closureValue b;
+    c->op[0]->handler(c->op[0], out);
+    c->op[1]->handler(c->op[1], &b);
+    out->data.number *= b.data.number;
+}
+
+void closureNumDiv(closure* c, closureValue* out)
+{
+    closureValue b;
+    c->op[0]->handler(c->op[0], out);
+    c->op[1]->handler(c->op[1], &b);
+    out->data.number /= b.data.number;
+}
+
+/* vector * number and vector / number */
+void closureVecScale(closure* c, closureValue* out)
+{
+    closureValue b;
+    c->op[0]->handler(c->op[0], out);
+    c->op[1]->handler(c->op[1], &b);
+    if(c->oper == '/')
+        b.data.number = 1/b.data.number;
+    vectorScale(&(out->data.vector), b.data.number, &(out->data.vector));
+}
+
+void closureCross(closure* c, closureValue* out)
+{
+    closureValue a, b;
+    c->op[0]->handler(c->op[0], &a);
+    c->op[1]->handler(c->op[1], &b);
+    out->type = typeVecConstant;
+    vectorCross(&(a.data.vector), &(b.data.vector), &(out->data.vector));
+}
+
+void closureDot(closure* c, closureValue* out)
+{
+    closureValue a, b;
+    c->op[0]->handler(c->op[0], &a);
+    c->op[1]->handler(c->op[1], &b);
+    out->type = typeNumConstant;
+    out->data.number = vectorDot(&(a.data.vector), &(b.data.vector));
+}
+
+void closureLess(closure* c, closureValue* out)
+{
+    closureValue a, b;
+    c->op[0]->handler(c->op[0], &a);
+    c->op[1]->handler(c->op[1], &b);
+    out->type = typeBool;
+    out->data.bool = a.data.number < b.data.number;
+}
+
+void closureGreater(closure* c, closureValue* out)
+{
+    closureValue a, b;
+    c->op[0]->handler(c->op[0], &a);
+    c->op[1]->handler(c->op[1], &b);
+    out->type = typeBool;
+    out->data.bool = a.data.number > b.data.number;
+}
+
+void closureGreaterEqual(closure* c, closureValue* out)
+{
+    closureValue a, b;
+    c->op[0]->handler(c->op[0], &a);
+    c->op[1]->handler(c->op[1], &b);
+    out->type = typeBool;
+    out->data.bool = a.data.number >= b.data.number;
+}
+
+void closureLessEqual(closure* c, closureValue* out)
+{
+    closureValue a, b;
+    c->op[0]->handler(c->op[0], &a);
+    c->op[1]->handler(c->op[1], &b);
+    out->type = typeBool;
+    out->data.bool = a.data.number <= b.data.number;
+}
+
+void closureNumEqual(closure* c, closureValue* out)
+{
+    closureValue a, b;
+    c->op[0]->handler(c->op[0], &a);
+    c->op[1]->handler(c->op[1], &b);
+    out->type = typeBool;
+    out->data.bool = numberCompare(a.data.number, b.data.number) == (c->oper == EQ);
+}
+
+void closureVecEqual(closure* c, closureValue* out)
+{
+    closureValue a, b;
+    c->op[0]->handler(c->op[0], &a);
+    c->op[1]->handler(c->op[1], &b);
+    out->type = typeBool;
+    out->data.bool = vectorCompare(&(a.data.vector), &(b.data.vector)) == (c->oper == EQ);
+}
+
+void closureToNumber(closure* c, closureValue* out)
+{
+    c->op[0]->handler(c->op[0], out);
+    out->type = typeNumConstant;
+    out->data.number = (real)out->data.integer;
+}
+
+void closureIntNegate(closure* c, closureValue* out)
+{
+    c->op[0]->handler(c->op[0], out);
+    out->data.integer = INTEGER_NEG(out->data.integer);
+}
+
+void closureIntAdd(closure* c, closureValue* out)
+{
+    closureValue b;
+    c->op[0]->handler(c->op[0], out);
+    c->op[1]->handler(c->op[1], &b);
+    out->data.integer = INTEGER_ADD(out->data.integer, b.data.integer);
+}
+
+void closureIntSub(closure* c, closureValue* out)
+{
+    closureValue b;
+    c->op[0]->handler(c->op[0], out);
+    c->op[1]->handler(c->op[1], &b);
+    out->data.integer = INTEGER_SUB(out->data.integer, b.data.integer);
+}
+
+void closureIntMul(closure* c, closureValue* out)
+{
+    closureValue b;
+    c->op[0]->handler(c->op[0], out);
+    c->op[1]->handler(c->op[1], &b);
+    out->data.integer = INTEGER_MUL(out->data.integer, b.data.integer);
+}
+
+void closureIntDiv(closure* c, closureValue* out)
+{
+    closureValue b;
+    c->op[0]->handler(c->op[0], out);
+    c->op[1]->handler(c->op[1], &b);
+    if(!integerDivide(out->data.integer, b.data.integer, &(out->data.integer)))
+        yyerror("ERROR: integer division by zero.");
+}
+
+/* ints are compared exactly */
+void closureIntLess(closure* c, closureValue* out)
+{
+    closureValue a, b;
+    c->op[0]->handler(c->op[0], &a);
+    c->op[1]->handler(c->op[1], &b);
+    out->type = typeBool;
+    out->data.bool = a.data.integer < b.data.integer;
+}
+
+void closureIntGreater(closure* c, closureValue* out)
+{
+    closureValue a, b;
+    c->op[0]->handler(c->op[0], &a);
+    c->op[1]->handler(c->op[1], &b);
+    out->type = typeBool;
+    out->data.bool = a.data.integer > b.data.integer;
+}
+
+void closureIntGreaterEqual(closure* c, closureValue* out)
+{
+    closureValue a, b;
+    c->op[0]->handler(c->op[0], &a);
+    c->op[1]->handler(c->op[1], &b);
+    out->type = typeBool;
+    out->data.bool = a.data.integer >= b.data.integer;
+}
+
+void closureIntLessEqual(closure* c, closureValue* out)
+{
+    closureValue a, b;
+    c->op[0]->handler(c->op[0], &a);
+    c->op[1]->handler(c->op[1], &b);
+    out->type = typeBool;
+    out->data.bool = a.data.integer <= b.data.integer;
+}
+
+void closureIntEqual(closure* c, closureValue* out)
+{
+    closureValue a, b;
+    c->op[0]->handler(c->op[0], &a);
+    c->op[1]->handler(c->op[1], &b);
+    out->type = typeBool;
+    out->data.bool = (a.data.integer == b.data.integer) == (c->oper == EQ);
+}
+
+/* the handler used when the types are only known at run time */
+void closureGeneric(closure* c, closureValue* out)
+{
+    closureValue a, b;
+
+    c->op[0]->handler(c->op[0], &a);
+    if(c->nops > 1)
+        c->op[1]->handler(c->op[1], &b);
+
+    if(!applyOperator(c->oper, &a, &b, out))
+    {
+        /* leave a harmless value behind the error */
+        out->type = typeBool;
+        out->data.bool = 0;
+    }
+}
+
+/* performs the operator with full type checking; returns false on errors */
+int applyOperator(int oper, closureValue* a, closureValue* b, closureValue* out)
+{
+    /* the whole-array operators are all left to Array.c */
+    if(IS_ARRAY(a->type) || (oper != UMINUS && IS_ARRAY(b->type)))
+    {
+        if(oper == UMINUS)
+            b = a;
+        if(oper == EQ || oper == NE)
+        {
+            out->type = typeBool;
+            out->data.bool = compareArrays(a->data.array, b->data.array) == (oper == EQ);
+            return 1;
+        }
+        if((out->data.array = arrayOperator(oper, a->type, &(a->data),
+                                            b->type, &(b->data))) == NULL)
+            return 0;
+        out->type = out->data.array->type;
+        return 1;
+    }
+
+    /* and those of vec2 and vec4 to VectorN.c */
+    if(IS_VECTOR_N(a->type) || (oper != UMINUS && IS_VECTOR_N(b->type)))
+    {
+        if(oper == UMINUS)
+            b = a;
+        out->type = vectorNOperator(oper, a->type, &(a->data), b->type, &(b->data),
+                                    &(out->data));
+        return out->type != -1;
+    }
+
+    switch(oper)
+    {
+        case UMINUS:
+            *out = *a;
+            switch(a->type)
+            {
+                case typeVecConstant:
+                    vectorNeg(&(a->data.vector), &(out->data.vector));
+                    return 1;
+                case typeNumConstant:
+                    out->data.number = -a->data.number;
+                    return 1;
+                case typeIntConstant:
+                    out->data.integer = INTEGER_NEG(a->data.integer);
+                    return 1;
+            }
+            yyerror("Wrong argument for negation.");
+            return 0;
+    }
+
+    /* the type checker sees to it that an int only meets another int */
+    if(a->type == typeIntConstant && b->type == typeIntConstant)
+    {
+        out->type = typeBool;
+        switch(oper)
+        {
+            case '<': out->data.bool = a->data.integer <  b->data.integer; return 1;
+            case '>': out->data.bool = a->data.integer >  b->data.integer; return 1;
+            case GE:  out->data.bool = a->data.integer >= b->data.integer; return 1;
+            case LE:  out->data.bool = a->data.integer <= b->data.integer; return 1;
+            case EQ:  out->data.bool = a->data.integer == b->data.integer; return 1;
+            case NE:  out->data.bool = a->data.integer != b->data.integer; return 1;
+        }
+
+        out->type = typeIntConstant;
+        switch(oper)
+        {
+            case '+': out->data.integer = INTEGER_ADD(a->data.integer, b->data.integer); return 1;
+            case '-': out->data.integer = INTEGER_SUB(a->data.integer, b->data.integer); return 1;
+            case '*': out->data.integer = INTEGER_MUL(a->data.integer, b->data.integer); return 1;
+            case '/':
+                if(integerDivide(a->data.integer, b->data.integer, &(out->data.integer)))
+                    return 1;
+                yyerror("ERROR: integer division by zero.");
+                return 0;
+        }
+    }
+
+    switch(oper)
+    {
+        case '+':
+        case '-':
+            if(a->type != b->type ||
+               (a->type != typeVecConstant && a->type != typeNumConstant))
+                break;
+            out->type = a->type;
+            if(a->type == typeVecConstant && oper == '+')
+                vectorAdd(&(a->data.vector), &(b->data.vector), &(out->data.vector));
+            else if(a->type == typeVecConstant)
+                vectorSub(&(a->data.vector), &(b->data.vector), &(out->data.vector));
+            else if(oper == '+')
+                out->data.number = a->data.number + b->data.number;
+            else
+                out->data.number = a->data.number - b->data.number;
+            return 1;
+
+        case '*':
+        case '/':
+            if(a->type == typeNumConstant && b->type == typeNumConstant)
+            {
+                out->type = typeNumConstant;
+                out->data.number = oper == '*' ? a->data.number * b->data.number
+                                               : a->data.number / b->data.number;
+                return 1;
+            }
+            if(a->type == typeNumConstant && b->type == typeVecConstant)
+            {
+                out->type = typeVecConstant;
+                vectorScale(&(b->data.vector),
+                            oper == '*' ? a->data.number : 1/a->data.number,
+                            &(out->data.vector));
+                return 1;
+            }
+            if(a->type == typeVecConstant && b->type == typeNumConstant)
+            {
+                out->type = typeVecConstant;
+                vectorScale(&(a->data.vector),
+                            oper == '*' ? b->data.number : 1/b->data.number,
+                            &(out->data.vector));
+                return 1;
+            }
+            yyerror("ERROR: vector multiplication is undefined.");
+            return 0;
+
+        case CROSS:
+        case DOT:
+            /* only defined for vectors */
+            if(a->type != typeVecConstant || b->type != typeVecConstant)
+                break;
+            if(oper == CROSS)
+            {
+                out->type = typeVecConstant;
+                vectorCross(&(a->data.vector), &(b->data.vector), &(out->data.vector));
+            }
+            else
+            {
+                out->type = typeNumConstant;
+                out->data.number = vectorDot(&(a->data.vector), &(b->data.vector));
+            }
+            return 1;
+
+        case '<':
+        case '>':
+        case GE:
+        case LE:
+            if(a->type != typeNumConstant)
+            {
+                yyerror("Incompatible types: operation can't be performed on vectors.");
+                return 0;
+            }
+            if(b->type != typeNumConstant)
+                break;
+            out->type = typeBool;
+            switch(oper)
+            {
+                case '<': out->data.bool = a->data.number <  b->data.number; break;
+                case '>': out->data.bool = a->data.number >  b->data.number; break;
+                case GE:  out->data.bool = a->data.number >= b->data.number; break;
+                case LE:  out->data.bool = a->data.number <= b->data.number; break;
+            }
+            return 1;
+
+        case EQ:
+        case NE:
+            if(a->type != b->type)
+                break;
+            out->type = typeBool;
+            if(a->type == typeVecConstant)
+                out->data.bool = vectorCompare(&(a->data.vector), &(b->data.vector));
+            else if(a->type == typeNumConstant)
+                out->data.bool = numberCompare(a->data.number, b->data.number);
+            else
+                break;
+            if(oper == NE)
+                out->data.bool = !out->data.bool;
+            return 1;
+    }
+
+    yyerror("Incompatible types: vector and a scalar.");
+    return 0;
+}
+
+closure* newClosure(closureHandler handler, int type)
+{
+    closure *c;
+
+    /* safely allocate space */
+    if((c = (closure*)calloc(1, sizeof(closure))) == NULL)
+        yyerror("Out of memory encountered.");
+
+    assert(c);
+    c->handler = handler;
+    c->type = type;
+    return c;
+}
+
+/* picks the handler for a binary operator, given the operand types */
+closureHandler specialiseOperator(int oper, int t1, int t2, int* type)
+{
+    int num = typeNumConstant, vec = typeVecConstant, in = typeIntConstant;
+
+    if(t1 == in && t2 == in)
+        switch(oper)
+        {
+            case '+':   *type = in; return closureIntAdd;
+            case '-':   *type = in; return closureIntSub;
+            case '*':   *type = in; return closureIntMul;
+            case '/':   *type = in; return closureIntDiv;
+            case '<':   *type = typeBool; return closureIntLess;
+            case '>':   *type = typeBool; return closureIntGreater;
+            case GE:    *type = typeBool; return closureIntGreaterEqual;
+            case LE:    *type = typeBool; return closureIntLessEqual;
+            case EQ:
+            case NE:    *type = typeBool; return closureIntEqual;
+        }
+
+    switch(oper)
+    {
+        case '+':
+            if(t1 == num && t2 == num) { *type = num; return closureNumAdd; }
+            if(t1 == vec && t2 == vec) { *type = vec; return closureVecAdd; }
+            break;
+        case '-':
+            if(t1 == num && t2 == num) { *type = num; return closureNumSub; }
+            if(t1 == vec && t2 == vec) { *type = vec; return closureVecSub; }
+            break;
+        case '*':
+            if(t1 == num && t2 == num) { *type = num; return closureNumMul; }
+            if(t1 == vec && t2 == num) { *type = vec; return closureVecScale; }
+            break;
+        case '/':
+            if(t1 == num && t2 == num) { *type = num; return closureNumDiv; }
+            if(t1 == vec && t2 == num) { *type = vec; return closureVecScale; }
+            break;
+        case CROSS:
+            if(t1 == vec && t2 == vec) { *type = vec; return closureCross; }
+            break;
+        case DOT:
+            if(t1 == vec && t2 == vec) { *type = num; return closureDot; }
+            break;
+        case '<':
+            if(t1 == num && t2 == num) { *type = typeBool; return closureLess; }
+            break;
+        case '>':
+            if(t1 == num && t2 == num) { *type = typeBool; return closureGreater; }
+            break;
+        case GE:
+            if(t1 == num && t2 == num) { *type = typeBool; return closureGreaterEqual; }
+            break;
+        case LE:
+            if(t1 == num && t2 == num) { *type = typeBool; return closureLessEqual; }
+            break;
+        case EQ:
+        case NE:
+            if(t1 == num && t2 == num) { *type = typeBool; return closureNumEqual; }
+            if(t1 == vec && t2 == vec) { *type = typeBool; return closureVecEqual; }
+            break;
+    }
+
+    /* the types are unknown or wrong - check them when running */
+    *type = -1;
+    return closureGeneric;
+}
+
+closure* compileClosureNode(nodeType* p)
+{
+    closure *c;
+    int i;
+
+    /* an empty statement still gets a handler, so none has to test for NULL */
+    if(!p) return newClosure(closureNothing, typeBool);
+
+    switch(p->type)
+    {
+        case typeNumConstant:
+            c = newClosure(closureConstant, typeNumConstant);
+            c->constant.type = typeNumConstant;
+            c->constant.data.number = p->con.data.number;
+            return c;
+
+        case typeVecConstant:
+            c = newClosure(closureConstant, typeVecConstant);
+            c->constant.type = typeVecConstant;
+            c->constant.data.vector = p->con.data.vector;
+            return c;
+
+        case typeIntConstant:
+            c = newClosure(closureConstant, typeIntConstant);
+            c->constant.type = typeIntConstant;
+            c->constant.data.integer = p->con.data.integer;
+            return c;
+
+        case typeVec2Constant:
+            c = newClosure(closureConstant, typeVec2Constant);
+            c->constant.type = typeVec2Constant;
+            c->constant.data.vector2 = p->con.data.vector2;
+            return c;
+
+        case typeVec4Constant:
+            c = newClosure(closureConstant, typeVec4Constant);
+            c->constant.type = typeVec4Constant;
+            c->constant.data.vector4 = p->con.data.vector4;
+            return c;
+
+        case typeId:
+            switch(p->id.idType)
+            {
+                case typeVecConstant:   c = newClosure(closureLoadVector, typeVecConstant); break;
+                case typeIntConstant:   c = newClosure(closureLoadInteger, typeIntConstant); break;
+                case typeVec2Constant:  c = newClosure(closureLoadVec2, typeVec2Constant); break;
+                case typeVec4Constant:  c = newClosure(closureLoadVec4, typeVec4Constant); break;
+                case typeVecArray:
+                case typeNumArray:      c = newClosure(closureLoadArray, p->id.idType); break;
+                default:                c = newClosure(closureLoadNumber, p->id.idType);
+            }
+            c->symbol = p->id.symbol;
+            return c;
+
+        case typeOperator:
+            break;
+
+        default:
+            assert(!"Compiling didn't match any rules");
+    }
+
+    if(p->opr.oper == SEQUENCE)
+        return compileClosureSequence(p->opr.op, p->opr.nops);
+
+    switch(p->opr.oper)
+    {
+        case WHILE:     c = newClosure(closureWhile, typeBool); break;
+        case IF:        c = newClosure(closureIf, typeBool); break;
+        case ';':       c = newClosure(closureSequence, typeBool); break;
+        case TO_NUMBER: c = newClosure(closureToNumber, typeNumConstant); break;
+        case PRINT:
+            c = newClosure(closurePrint, typeBool);
+            /* variables are printed together with their names */
+            if(p->opr.op[0]->type == typeId)
+                c->name = p->opr.op[0]->id.id;
+            break;
+        case '=':
+            /* the assigned variable is bound; its type is kept as the constant's */
+            c = newClosure(closureStore, typeBool);
+            c->symbol = p->opr.op[0]->id.symbol;
+            c->constant.type = p->opr.op[0]->id.idType;
+            c->op[0] = compileClosureNode(p->opr.op[1]);
+            c->nops = 1;
+            return c;
+        case VEC_ARRAY:
+        case NUM_ARRAY:
+            c = newClosure(closureNewArray, p->opr.oper == VEC_ARRAY ? typeVecArray : typeNumArray);
+            c->constant.type = c->type;
+            break;
+        case INDEX:
+        case INDEX_ASSIGN:
+            /* the array is bound; only the index and the value are operands */
+            if(p->opr.oper == INDEX)
+                c = newClosure(closureIndex, elementType(p->opr.op[0]->id.idType));
+            else
+                c = newClosure(closureStoreIndex, typeBool);
+            c->symbol = p->opr.op[0]->id.symbol;
+            c->nops = p->opr.nops - 1;
+            for(i = 0; i < c->nops; ++i)
+                c->op[i] = compileClosureNode(p->opr.op[i + 1]);
+            return c;
+        default:
+            c = newClosure(closureGeneric, -1);
+    }
+
+    c->oper = p->opr.oper;
+    c->nops = p->opr.nops;
+    for(i = 0; i < p->opr.nops; ++i)
+        c->op[i] = compileClosureNode(p->opr.op[i]);
+
+    /* now the operand types are known, pick the specialised handler;
+       the operators of arrays, vec2 and vec4 stay generic, so only their
+       type is worked out */
+    if(c->handler == closureGeneric)
+    {
+        if(IS_ARRAY(c->op[0]->type) || (c->nops > 1 && IS_ARRAY(c->op[1]->type)))
+            c->type = arrayOperatorType(c->oper, c->op[0]->type,
+                                        c->nops > 1 ? c->op[1]->type : c->op[0]->type);
+        else if(IS_VECTOR_N(c->op[0]->type) || (c->nops > 1 && IS_VECTOR_N(c->op[1]->type)))
+            c->type = vectorNOperatorType(c->oper, c->op[0]->type,
+                                          c->nops > 1 ? c->op[1]->type : c->op[0]->type);
+        else if(c->oper == UMINUS)
+        {
+            if(c->op[0]->type == typeNumConstant)
+                c->handler = closureNumNegate;
+            else if(c->op[0]->type == typeVecConstant)
+                c->handler = closureVecNegate;
+            else if(c->op[0]->type == typeIntConstant)
+                c->handler = closureIntNegate;
+            c->type = c->handler == closureGeneric ? -1 : c->op[0]->type;
+        }
+        else
+            c->handler = specialiseOperator(c->oper, c->op[0]->type,
+                                            c->op[1]->type, &(c->type));
+    }
+    return c;
+}
+
+/* the statements of a block become a balanced tree of sequences, so the
+   handlers of a long block don't nest deeply */
+closure* compileClosureSequence(nodeType** statements, int count)
+{
+    closure *c, *line;
+
+    if(count == 1)
+    {
+        c = compileClosureNode(statements[0]);
+
+        /* a kept statement first makes its line the current one */
+        if(statements[0] && statements[0]->type == typeOperator &&
+           statements[0]->opr.line)
+        {
+            line = newClosure(closureLine, c->type);
+            line->constant.data.integer = statements[0]->opr.line;
+            line->nops = 1;
+            line->op[0] = c;
+            return line;
+        }
+        return c;
+    }
+
+    c = newClosure(closureSequence, typeBool);
+    c->oper = SEQUENCE;
+    c->nops = 2;
+    c->op[0] = compileClosureSequence(statements, count / 2);
+    c->op[1] = compileClosureSequence(statements + count / 2, count - count / 2);
+    return c;
+}
+
+closure* compileClosure(nodeType* p)
+{
+    return compileClosureNode(p);
+}
+
+void runClosure(closure* c)
+{
+    closureValue result;
+
+    closureErrors = errorCount;
+    c->handler(c, &result);
+}
+
+void freeClosure(closure* c)
+{
+    int i;
+
+    /* check if the closure is free already; if yes - return */
+    if(!c) return;
+
+    for(i = 0; i < c->nops; ++i)
+        freeClosure(c->op[i]);
+
+    free(c);
+}
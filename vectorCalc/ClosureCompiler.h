@@ -0,0 +1,16 @@
+/*
+   Prototype functions for the closure compiler.
+*/
+
+#include "ParseTree.h"
+
+/* A node of the parse tree turned into a handler with bound operands. */
+typedef struct closureTag closure;
+
+/* Pre-resolves the parse tree of a single statement into closures. */
+closure* compileClosure(nodeType*);
+
+/* Runs the statement by calling the handlers. */
+void runClosure(closure*);
+
+void freeClosure(closure*);
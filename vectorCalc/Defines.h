@@ -9,21 +9,82 @@
 #ifdef _MSC_VER // maybe check the specific version, too...
     #define SSCANF sscanf_s
     #define SPRINTF sprintf_s
+    typedef __int64 int64;
+    #define INT64_FORMAT "%I64d"
+    #define STRTOLL _strtoi64
+    #define ALIGN16 __declspec(align(16))
 #else
     #define SSCANF sscanf
     #define SPRINTF snprintf
+    typedef long long int64;
+    #define INT64_FORMAT "%lld"
+    #define STRTOLL strtoll
+    #define ALIGN16 __attribute__((aligned(16)))
 #endif
 
 #include <stdlib.h>
 
+/* The type numbers and vector components are stored and computed in.
+   Built with SINGLE_PRECISION they are floats: half the memory traffic
+   and twice the lanes of a SIMD register, for about 7 significant digits
+   instead of 16. Printing promotes either to double, so the output keeps
+   its two decimal places, which a float still holds exactly below 10^5. */
+#ifdef SINGLE_PRECISION
+    typedef float real;
+    #define REAL_SCAN "%f"
+#else
+    typedef double real;
+    #define REAL_SCAN "%lf"
+#endif
+
+/* how numbers and vectors are printed */
+#define NUMBER_FORMAT "%0.2f"
+#define VECTOR_FORMAT "{%0.2f, %0.2f, %0.2f}"
+#define VEC2_FORMAT "{%0.2f, %0.2f}"
+#define VEC4_FORMAT "{%0.2f, %0.2f, %0.2f, %0.2f}"
+
 /* error funciton prototype */
 void yyerror(char *);
 
 /* all the semantic errors are enumerated */
 typedef enum { notDeclared, alreadyDeclared } serrorEnum;
 
+#ifdef PADDED_VECTORS
+/* Built with PADDED_VECTORS, a vector is padded to four lanes and 16-byte
+   aligned, so Math.c loads it as two SSE2 registers - {x, y} and {z, w} -
+   or, in single precision, as one.
+   The heap and the arenas hand out 16-byte-aligned blocks on the 64-bit
+   targets. w is padding, and takes no part in any result. */
+typedef struct ALIGN16 {
+    real x, y, z, w;
+} vector3;
+#else
 typedef struct {
-    double x, y, z;
+    real x, y, z;
 } vector3;
+#endif
+
+/* The 2- and 4-dimensional vectors, vec2 and vec4 in a script; vector3
+   is vec3. Only the components a vector has are stored and computed. */
+typedef struct {
+    real x, y;
+} vec2;
+
+typedef struct {
+    real x, y, z, w;
+} vec4;
+
+/* An array of vectors, stored as a structure of arrays: the x, y and z
+   components each lie in a contiguous column of their own. An array of
+   numbers only has the x column. */
+typedef struct vectorArrayTag {
+    int type;                       /* typeVecArray or typeNumArray */
+    int length;                     /* number of elements */
+    real *x, *y, *z;                /* the columns */
+    int temporary;                  /* not held by a variable; freed once
+                                       it has been used */
+    struct vectorArrayTag *previous, *next; /* the temporaries still
+                                       alive */
+} vectorArray;
 
 #endif
@@ -9,70 +9,158 @@
 #include "SymbolTable.h"
 #include "vectorCalc.tab.h"
 #include "Math.h"
+#include "BytecodeCompiler.h"
+#include "VirtualMachine.h"
+#include "ClosureCompiler.h"
+#include "JitCompiler.h"
+#include "Transpiler.h"
+#include "ParseTreeBuilder.h"
+#include "Optimiser.h"
+#include "TypeChecker.h"
+#include "LinearTree.h"
+#include "Array.h"
+#include "VectorN.h"
 
 /* functions prototypes */
-payload* newResult(int);
-vector3* newVector(double x, double y, double z);
+payload newResult(int);
+payload evaluateOperator(nodeType*, payload, payload);
+payload evaluateInteger(nodeType*, payload, payload);
+payload evaluateArray(nodeType*, payload, payload);
+payload evaluateVectorN(nodeType*, payload, payload);
+payload arrayPayload(vectorArray*);
+void quicken(nodeType*, int, int);
+payload deoptimise(nodeType*, payload, payload);
+void keepStatement(nodeType*);
+void runStatement(nodeType*);
 
 /* The output file defined in MainApp.c */
 extern FILE *dataFile;
 
-payload* newResult(int type)
-{
-    payload *p;
+/* The execution mode defined in main.c */
+extern int executionMode;
+
+/* The number of errors detected, defined in vectorCalc.y */
+extern int errorCount;
+
+/* The current line, defined in vectorCalc.l */
+extern int yylinenum;
+
+/* Whether the optimiser runs, defined in main.c */
+extern int optimiserEnabled;
 
-    /* safely allocate space */
-    if((p = (payload*)malloc(sizeof(payload))) == NULL)
-        yyerror("Out of memory encountered.");
+/* Whether the tree walker quickens operators, defined in main.c */
+extern int quickeningEnabled;
 
-    assert(p);
-    p->type = type;
+/* Whether the script is run as a whole, defined in main.c */
+extern int wholeScriptEnabled;
+
+/* The script being run, defined in main.c */
+extern char *scriptPath;
+
+/* The statements kept in compile or whole-script mode, in the script
+   order */
+nodeType **program = NULL;
+int programCount = 0, programCapacity = 0;
+
+/* The number of errors when the running statement started; its blocks
+   and loops stop once it rises, as the parser does */
+int statementErrors = 0;
+
+payload newResult(int type)
+{
+    payload p;
+
+    /* results are passed by value, so nothing is allocated */
+    p.type = type;
 
     /* set invalid values to avoid any garbage results */
-    p->data.vector = NULL;
-    p->data.number = -1;
-    p->data.bool = -1;
+    p.data.vector.x = p.data.vector.y = p.data.vector.z = 0;
+    p.data.number = -1;
+    p.data.bool = -1;
 
     return p;
 }
 
-payload* interpret(nodeType* p)
+payload interpret(nodeType* p)
 {
     /* if we're given NULL - return instantly */
-    if(!p) return 0;
+    if(!p) return newResult(typeBool);
 
     switch(p->type)
     {
         case typeNumConstant:
         {
-            payload *res = newResult(typeNumConstant);
-            res->data.number = p->con.number;
+            payload res = newResult(typeNumConstant);
+            res.data.number = p->con.data.number;
             return res;
         }
 
         case typeVecConstant:
         {
-            payload *res = newResult(typeVecConstant);
-            res->data.vector = p->con.vector;
+            payload res = newResult(typeVecConstant);
+            res.data.vector = p->con.data.vector;
+            return res;
+        }
+
+        case typeIntConstant:
+        {
+            payload res = newResult(typeIntConstant);
+            res.data.integer = p->con.data.integer;
+            return res;
+        }
+
+        case typeVec2Constant:
+        {
+            payload res = newResult(typeVec2Constant);
+            res.data.vector2 = p->con.data.vector2;
+            return res;
+        }
+
+        case typeVec4Constant:
+        {
+            payload res = newResult(typeVec4Constant);
+            res.data.vector4 = p->con.data.vector4;
             return res;
         }
 
+        case typeVecArray:
+        case typeNumArray:
+            /* arrays are only ever created by VEC_ARRAY and NUM_ARRAY,
+               there are no array constants */
+            break;
+
         case typeId:
         {
             /* get the type of the variable */
             int type = p->id.idType;
             /* create the appropriate result container */
-            payload *res = newResult(type);
+            payload res = newResult(type);
+            symbolEntry *symbol = p->id.symbol;
             
-            switch(type)
-            {
-                case typeVecConstant:
-                    getValue(p->id.id, type, &(res->data.vector));
-                    break;
-                case typeNumConstant:
-                    getValue(p->id.id, type, &(res->data.number));
-                    break;
-            }
+            if(symbol)
+                switch(type)
+                {
+                    case typeVecConstant:
+                        res.data.vector = symbol->data.vector;
+                        break;
+                    case typeNumConstant:
+                        res.data.number = symbol->data.number;
+                        break;
+                    case typeIntConstant:
+                        res.data.integer = symbol->data.integer;
+                        break;
+                    case typeVec2Constant:
+                        res.data.vector2 = symbol->data.vector2;
+                        break;
+                    case typeVec4Constant:
+                        res.data.vector4 = symbol->data.vector4;
+                        break;
+                    case typeVecArray:
+                    case typeNumArray:
+                        /* an array is used where it is, never copied */
+                        res.data.array = &symbol->data.array;
+                        break;
+                }
 
             return res;
         }
@@ -84,15 +172,15 @@ payload* interpret(nodeType* p)
                     case WHILE:
                     {
                         /* evaluate the operands */
-                        payload *condition = interpret(p->opr.op[0]);
+                        payload condition = interpret(p->opr.op[0]);
                         /* all control statements return 0 */
-                        payload *result = newResult(typeBool);
+                        payload result = newResult(typeBool);
                         /* evaluate the operands */
-                        if(condition->type != typeBool)
+                        if(condition.type != typeBool)
                             yyerror("WHILE failed, the condition is not of type BOOL.");
 
                         /* while the condition holds, */
-                        while(condition->data.bool)
+                        while(condition.data.bool && errorCount == statementErrors)
                         {
                             /* re-evaluate the condition */
                             condition = interpret(p->opr.op[0]);
@@ -100,493 +188,1224 @@ payload* interpret(nodeType* p)
                             interpret(p->opr.op[1]);
                         }
                         
-                        result->data.bool = 0;
+                        result.data.bool = 0;
                         return result;
                     }
 
                     case IF:
                     {
                         /* evaluate the operands */
-                        payload *condition = interpret(p->opr.op[0]);
+                        payload condition = interpret(p->opr.op[0]);
                         /* all control statements return 0 */
-                        payload *result = newResult(typeBool);
+                        payload result = newResult(typeBool);
 
                         /* evaluate the operands */
-                        if(condition->type != typeBool)
+                        if(condition.type != typeBool)
                             yyerror("IF failed, the condition is not of type BOOL.");
 
-                        if(condition->data.bool)
+                        if(condition.data.bool)
                             interpret(p->opr.op[1]);
                         /* this can be an if-else */
                         else if(p->opr.nops > 2)
                             interpret(p->opr.op[2]);
 
-                        result->data.bool = 0;
+                        result.data.bool = 0;
                         return result;
                     }
 
-                    case PRINT:
-                    {
-                        /* evaluate the operands */
-                        payload *res;
-						payload *toPrint;
-						
-						res = newResult(typeBool);
-
-                        if(p->opr.op[0]->type == typeId)
-                            fprintf(dataFile, "%s = ", p->opr.op[0]->id.id);
-
-						toPrint = interpret(p->opr.op[0]);
-
-                        switch(toPrint->type)
-                        {
-                            case typeVecConstant:
-                                res->data.bool = fprintf(dataFile, "{%0.2f, %0.2f, %0.2f}\n",
-                                                         toPrint->data.vector->x,
-                                                         toPrint->data.vector->y,
-                                                         toPrint->data.vector->z);
-                            break;
-                            case typeNumConstant:
-                                res->data.bool = fprintf(dataFile, "%0.2f\n", toPrint->data.number);
-                            break;
-                            default:
-                                yyerror("Wrong argument for printing.");
-                        }
-                        assert(res);
-                        return res;
-                    }
-                        
                     case ';':
                     {
                         interpret(p->opr.op[0]);
+                        if(errorCount != statementErrors)
+                            return newResult(typeBool);
                         return interpret(p->opr.op[1]);
                     }
 
-                    case '=':
+                    case SEQUENCE:
                     {
-                        /* all control statements return 0 */
-                        payload *result = newResult(typeBool);
-                        nodeType *lhs = p->opr.op[0];
-                        payload *rhs = interpret(p->opr.op[1]);
-                        
-                        assert(rhs);
+                        /* the statements of a block, one after another,
+                           up to the first error */
+                        int i, last = p->opr.nops - 1;
 
-                        /* Very simple type-checking */
-                        if(isDeclared(lhs->id.id) && lhs->id.idType != rhs->type)
-                            yyerror("ERROR: Incompatible types to assign.");
-                        
-                        switch(rhs->type)
+                        for(i = 0; i < last; ++i)
                         {
-                            case typeVecConstant:
-                                result->data.bool = setValue(p->opr.op[0]->id.id,
-                                                             rhs->type, rhs->data.vector);
-                                break;
-                            case typeNumConstant:
-                                result->data.bool = setValue(p->opr.op[0]->id.id,
-                                                             rhs->type, &(rhs->data.number));
-                                break;
+                            statementLine(p->opr.op[i]);
+                            interpret(p->opr.op[i]);
+                            if(errorCount != statementErrors)
+                                return newResult(typeBool);
                         }
+                        statementLine(p->opr.op[last]);
+                        return interpret(p->opr.op[last]);
+                    }
+
+                    case TO_NUMBER:
+                    {
+                        payload operand = interpret(p->opr.op[0]);
+                        payload result = newResult(typeNumConstant);
+                        result.data.number = (real)operand.data.integer;
                         return result;
                     }
 
-                    case UMINUS:
+                    case VEC_ARRAY:
+                    case NUM_ARRAY:
                     {
-                        /* evaluate the operand */
-                        payload *operand = interpret(p->opr.op[0]);
-                        payload *result = NULL;
-                        switch(operand->type)
-                        {
-                            case typeVecConstant:
-                                result = newResult(typeVecConstant);
-                                result->data.vector = vectorNeg_new(operand->data.vector);
-                                break;
-                            case typeNumConstant:
-                                result = newResult(typeNumConstant);
-                                result->data.number = -operand->data.number;
-                                break;
-                            default:
-                                yyerror("Wrong argument for negation.");
+                        payload size = interpret(p->opr.op[0]);
+                        return arrayPayload(newArray(p->opr.oper == VEC_ARRAY ?
+                                                     typeVecArray : typeNumArray,
+                                                     size.data.integer));
+                    }
 
-                        }
-                        assert(result);
+                    case INDEX:
+                    {
+                        nodeType *array = p->opr.op[0];
+                        payload index = interpret(p->opr.op[1]);
+                        payload result = newResult(elementType(array->id.idType));
+
+                        if(!getElement(&array->id.symbol->data.array, index.data.integer,
+                                       &result.data))
+                            return newResult(-1);
                         return result;
                     }
 
-                    case '+':
+                    case INDEX_ASSIGN:
                     {
-                        /* evaluate the operands */
-                        payload *op1 = interpret(p->opr.op[0]);
-                        payload *op2 = interpret(p->opr.op[1]);
-                        payload *result = NULL;
-                        
-                        /* test if the types match */
-                        if(op1->type != op2->type)
-                            yyerror("Incompatible types: vector and a scalar.");
-                        
-                        /* decide if we're performing vector or scalar addition */
-                        switch(op1->type)
-                        {
-                            case typeVecConstant:
-                                /* set VECTOR as the return type */
-                                result = newResult(typeVecConstant);
-                                result->data.vector = vectorAdd_new(op1->data.vector,
-                                                                    op2->data.vector);
-                                break;
-                            case typeNumConstant:
-                                if(op2->type == typeVecConstant)
-                                    yyerror("Incompatible types: vector and a scalar.");
-
-                                /* set typeNumConstant as the return type */
-                                result = newResult(typeNumConstant);
-                                /* do the actual calculations */
-                                result->data.number = op1->data.number + op2->data.number;
-                                break;
-                            default:
-                                yyerror("Incompatible types: vector and a scalar.");
-                        }
+                        payload index = interpret(p->opr.op[1]);
+                        payload value = interpret(p->opr.op[2]);
+                        payload result = newResult(typeBool);
 
-                        assert(result);
+                        result.data.bool = setElement(&p->opr.op[0]->id.symbol->data.array,
+                                                      index.data.integer, &value.data);
                         return result;
                     }
 
-                    case '-':
+                    /* The specialised operators, which the type checker
+                       or quickening rewrote the generic ones into. Each
+                       checks that its operands have the types it was
+                       specialised for, and if they don't it turns back
+                       into the generic operator. */
+                    case NUM_PRINT:
+                    case VEC_PRINT:
                     {
-                        /* evaluate the operands */
-                        payload *op1 = interpret(p->opr.op[0]);
-                        payload *op2 = interpret(p->opr.op[1]);
-                        payload *result = NULL;
-                        
-                        /* test if the types match */
-                        if(op1->type != op2->type)
-                            yyerror("Incompatible types: vector and a scalar.");
-                        
-                        /* decide if we're performing vector or scalar subtraction */
-                        switch(op1->type)
-                        {
-                            case typeVecConstant:
-                                /* set VECTOR as the return type */
-                                result = newResult(typeVecConstant);
-                                result->data.vector = vectorSub_new(op1->data.vector,
-                                                                    op2->data.vector);
-                                break;
-                            case typeNumConstant:
-                                /* set typeNumConstant as the return type */
-                                result = newResult(typeNumConstant);
-                                /* do the actual calculations */
-                                result->data.number = op1->data.number - op2->data.number;
-                                break;
-                            default:
-                                yyerror("Incompatible types: vector and a scalar.");
-                        }
+                        payload toPrint = interpret(p->opr.op[0]);
+                        payload res = newResult(typeBool);
+
+                        if(toPrint.type != (p->opr.oper == NUM_PRINT ? typeNumConstant : typeVecConstant))
+                            return deoptimise(p, toPrint, toPrint);
 
-                        assert(result);
+                        if(p->opr.op[0]->type == typeId)
+                            fprintf(dataFile, "%s = ", p->opr.op[0]->id.id);
+
+                        if(p->opr.oper == VEC_PRINT)
+                            res.data.bool = fprintf(dataFile, VECTOR_FORMAT "\n",
+                                                    toPrint.data.vector.x,
+                                                    toPrint.data.vector.y,
+                                                    toPrint.data.vector.z);
+                        else
+                            res.data.bool = fprintf(dataFile, NUMBER_FORMAT "\n", toPrint.data.number);
+                        return res;
+                    }
+
+                    case NUM_ASSIGN:
+                    {
+                        payload rhs = interpret(p->opr.op[1]);
+                        payload result = newResult(typeBool);
+
+                        if(rhs.type != typeNumConstant)
+                            return deoptimise(p, result, rhs);
+                        p->opr.op[0]->id.symbol->data.number = rhs.data.number;
+                        result.data.bool = 1;
                         return result;
                     }
 
-                    case '*':
+                    case VEC_ASSIGN:
                     {
-                        /* evaluate the operands */
-                        payload *op1 = interpret(p->opr.op[0]);
-                        payload *op2 = interpret(p->opr.op[1]);
-                        payload *result = NULL;
-                        
-                        /* decide if we're performing vector or scalar multiplication */
-                        switch(op1->type)
-                        {
-                            case typeNumConstant:
-                                switch(op2->type)
-                                {
-                                    case typeNumConstant:
-                                        /* set typeNumConstant as the return type */
-                                        result = newResult(typeNumConstant);
-                                        /* do the actual calculations */
-                                        result->data.number = op1->data.number * op2->data.number;
-                                        break;
-                                    case typeVecConstant:
-                                        /* set typeVecConstant as the return type */
-                                        result = newResult(typeVecConstant);
-                                        result->data.vector = vectorScale_new(op2->data.vector,
-                                                                              op1->data.number);
-                                        break;
-                                }
-                            case typeVecConstant:
-                                switch(op2->type)
-                                {
-                                    case typeNumConstant:
-                                        /* set typeNumConstant as the return type */
-                                        result = newResult(typeVecConstant);
-                                        /* do the actual calculations */
-                                        result->data.vector = vectorScale_new(op1->data.vector,
-                                                                              op2->data.number);
-                                        break;
-                                    case typeVecConstant:
-                                        yyerror("ERROR: vector multiplication is undefined.");
-                                        break;
-                                }
-                        }
+                        payload rhs = interpret(p->opr.op[1]);
+                        payload result = newResult(typeBool);
 
-                        assert(result);
+                        if(rhs.type != typeVecConstant)
+                            return deoptimise(p, result, rhs);
+                        p->opr.op[0]->id.symbol->data.vector = rhs.data.vector;
+                        result.data.bool = 1;
                         return result;
                     }
 
-                    case '/':
+                    case NUM_NEG:
                     {
-                        /* evaluate the operands */
-                        payload *op1 = interpret(p->opr.op[0]);
-                        payload *op2 = interpret(p->opr.op[1]);
-                        payload *result = NULL;
-                        
-                        /* decide if we're performing vector or scalar division */
-                        switch(op1->type)
-                        {
-                            case typeNumConstant:
-                                switch(op2->type)
-                                {
-                                    case typeNumConstant:
-                                        /* set typeNumConstant as the return type */
-                                        result = newResult(typeNumConstant);
-                                        /* do the actual calculations */
-                                        result->data.number = op1->data.number * op2->data.number;
-                                        break;
-                                    case typeVecConstant:
-                                        /* set typeVecConstant as the return type */
-                                        result = newResult(typeVecConstant);
-                                        result->data.vector = vectorScale_new(op2->data.vector,
-                                                                              1/op1->data.number);
-                                        break;
-                                }
-                            case typeVecConstant:
-                                switch(op2->type)
-                                {
-                                    case typeNumConstant:
-                                        /* set typeNumConstant as the return type */
-                                        result = newResult(typeVecConstant);
-                                        /* do the actual calculations */
-                                        result->data.vector = vectorScale_new(op1->data.vector,
-                                                                              1/op2->data.number);
-                                        break;
-                                    case typeVecConstant:
-                                        yyerror("ERROR: vector multiplication is undefined.");
-                                        break;
-                                }
-                        }
-                        assert(result);
+                        payload result = interpret(p->opr.op[0]);
+                        if(result.type != typeNumConstant)
+                            return deoptimise(p, result, result);
+                        result.data.number = -result.data.number;
                         return result;
                     }
 
-                    case CROSS:
+                    case VEC_NEG:
                     {
-                        /* evaluate the operands */
-                        payload *op1 = interpret(p->opr.op[0]);
-                        payload *op2 = interpret(p->opr.op[1]);
-                        payload *result = NULL;
-                        
-                        /* cross product is only defined for vectors */
-                        if(op1->type == typeNumConstant && op2->type == typeNumConstant)
-                            yyerror("Incompatible types: vector and a scalar.");
+                        payload result = interpret(p->opr.op[0]);
+                        if(result.type != typeVecConstant)
+                            return deoptimise(p, result, result);
+                        vectorNeg(&result.data.vector, &result.data.vector);
+                        return result;
+                    }
 
-                        /* set typeNumConstant as the return type */
-                        result = newResult(typeVecConstant);
-                        /* do the actual calculations */
-                        result->data.vector = vectorCross_new(op1->data.vector,
-                                                              op2->data.vector);
+                    case NUM_ADD:
+                    {
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        if(op1.type != typeNumConstant || op2.type != typeNumConstant)
+                            return deoptimise(p, op1, op2);
+                        op1.data.number = op1.data.number + op2.data.number;
+                        return op1;
+                    }
 
-                        assert(result);
-                        return result;
+                    case VEC_ADD:
+                    {
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        if(op1.type != typeVecConstant || op2.type != typeVecConstant)
+                            return deoptimise(p, op1, op2);
+                        vectorAdd(&op1.data.vector, &op2.data.vector, &op1.data.vector);
+                        return op1;
                     }
 
-                    case DOT:
+                    case NUM_SUB:
                     {
-                        /* evaluate the operands */
-                        payload *op1 = interpret(p->opr.op[0]);
-                        payload *op2 = interpret(p->opr.op[1]);
-                        payload *result = NULL;
-                        
-                        /* cross product is only defined for vectors */
-                        if(op1->type == typeNumConstant && op2->type == typeNumConstant)
-                            yyerror("Incompatible types: vector and a scalar.");
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        if(op1.type != typeNumConstant || op2.type != typeNumConstant)
+                            return deoptimise(p, op1, op2);
+                        op1.data.number = op1.data.number - op2.data.number;
+                        return op1;
+                    }
 
-                        /* set typeNumConstant as the return type */
-                        result = newResult(typeNumConstant);
-                        /* do the actual calculations */
-                        result->data.number = vectorDot(op1->data.vector,
-                                                        op2->data.vector);
+                    case VEC_SUB:
+                    {
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        if(op1.type != typeVecConstant || op2.type != typeVecConstant)
+                            return deoptimise(p, op1, op2);
+                        vectorSub(&op1.data.vector, &op2.data.vector, &op1.data.vector);
+                        return op1;
+                    }
 
-                        assert(result);
-                        return result;
+                    case NUM_MUL:
+                    {
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        if(op1.type != typeNumConstant || op2.type != typeNumConstant)
+                            return deoptimise(p, op1, op2);
+                        op1.data.number = op1.data.number * op2.data.number;
+                        return op1;
                     }
 
-                    case '<':
+                    case VEC_SCALE:
                     {
-                        /* evaluate the operands */
-                        payload *op1 = interpret(p->opr.op[0]);
-                        payload *op2 = interpret(p->opr.op[1]);
-                        payload *result = NULL;
-                        
-                        if(op1->type == typeNumConstant)
-                        {
-                            if(op2->type == typeVecConstant)
-                                yyerror("Incompatible types: vector and a scalar.");
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        if(op1.type != typeVecConstant || op2.type != typeNumConstant)
+                            return deoptimise(p, op1, op2);
+                        vectorScale(&op1.data.vector, op2.data.number, &op1.data.vector);
+                        return op1;
+                    }
 
-                            /* set typeBool as the return type */
-                            result = newResult(typeBool);
-                            /* do the actual calculations */
-                            result->data.bool = op1->data.number < op2->data.number;
-                        }
-                        else
-                            yyerror("Incompatible types: operation can't be performed on vectors.");
+                    case SCALE_VEC:
+                    {
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        if(op1.type != typeNumConstant || op2.type != typeVecConstant)
+                            return deoptimise(p, op1, op2);
+                        vectorScale(&op2.data.vector, op1.data.number, &op2.data.vector);
+                        return op2;
+                    }
 
-                        assert(result);
-                        return result;
+                    case NUM_DIV:
+                    {
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        if(op1.type != typeNumConstant || op2.type != typeNumConstant)
+                            return deoptimise(p, op1, op2);
+                        op1.data.number = op1.data.number / op2.data.number;
+                        return op1;
                     }
 
-                    case '>':
+                    case VEC_DIV:
                     {
-                        /* evaluate the operands */
-                        payload *op1 = interpret(p->opr.op[0]);
-                        payload *op2 = interpret(p->opr.op[1]);
-                        payload *result = NULL;
-                        
-                        if(op1->type == typeNumConstant)
-                        {
-                            if(op2->type == typeVecConstant)
-                                yyerror("Incompatible types: vector and a scalar.");
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        if(op1.type != typeVecConstant || op2.type != typeNumConstant)
+                            return deoptimise(p, op1, op2);
+                        vectorScale(&op1.data.vector, 1/op2.data.number, &op1.data.vector);
+                        return op1;
+                    }
 
-                            /* set typeBool as the return type */
-                            result = newResult(typeBool);
-                            /* do the actual calculations */
-                            result->data.bool = op1->data.number > op2->data.number;
-                        }
-                        else
-                            yyerror("Incompatible types: operation can't be performed on vectors.");
+                    case DIV_VEC:
+                    {
+                        /* the vector is divided, whichever side it is on */
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        if(op1.type != typeNumConstant || op2.type != typeVecConstant)
+                            return deoptimise(p, op1, op2);
+                        vectorScale(&op2.data.vector, 1/op1.data.number, &op2.data.vector);
+                        return op2;
+                    }
 
-                        assert(result);
+                    case VEC_CROSS:
+                    {
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        payload result = newResult(typeVecConstant);
+                        if(op1.type != typeVecConstant || op2.type != typeVecConstant)
+                            return deoptimise(p, op1, op2);
+                        vectorCross(&op1.data.vector, &op2.data.vector, &result.data.vector);
                         return result;
                     }
 
-                    case GE:
+                    case VEC_DOT:
                     {
-                        /* evaluate the operands */
-                        payload *op1 = interpret(p->opr.op[0]);
-                        payload *op2 = interpret(p->opr.op[1]);
-                        payload *result = NULL;
-                        
-                        if(op1->type == typeNumConstant)
-                        {
-                            if(op2->type == typeVecConstant)
-                                yyerror("Incompatible types: vector and a scalar.");
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        payload result = newResult(typeNumConstant);
+                        if(op1.type != typeVecConstant || op2.type != typeVecConstant)
+                            return deoptimise(p, op1, op2);
+                        result.data.number = vectorDot(&op1.data.vector, &op2.data.vector);
+                        return result;
+                    }
 
-                            /* set typeBool as the return type */
-                            result = newResult(typeBool);
-                            /* do the actual calculations */
-                            result->data.bool = op1->data.number >= op2->data.number;
+                    case NUM_LT:
+                    case NUM_GT:
+                    case NUM_GE:
+                    case NUM_LE:
+                    case NUM_EQ:
+                    case NUM_NE:
+                    {
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        payload result = newResult(typeBool);
+                        real n1 = op1.data.number, n2 = op2.data.number;
+
+                        if(op1.type != typeNumConstant || op2.type != typeNumConstant)
+                            return deoptimise(p, op1, op2);
+
+                        switch(p->opr.oper)
+                        {
+                            case NUM_LT: result.data.bool = n1 < n2; break;
+                            case NUM_GT: result.data.bool = n1 > n2; break;
+                            case NUM_GE: result.data.bool = n1 >= n2; break;
+                            case NUM_LE: result.data.bool = n1 <= n2; break;
+                            case NUM_EQ: result.data.bool = numberCompare(n1, n2); break;
+                            case NUM_NE: result.data.bool = !numberCompare(n1, n2); break;
                         }
-                        else
-                            yyerror("Incompatible types: operation can't be performed on vectors.");
+                        return result;
+                    }
 
-                        assert(result);
+                    case VEC_EQ:
+                    case VEC_NE:
+                    {
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        payload result = newResult(typeBool);
+                        if(op1.type != typeVecConstant || op2.type != typeVecConstant)
+                            return deoptimise(p, op1, op2);
+                        result.data.bool = vectorCompare(&op1.data.vector, &op2.data.vector);
+                        if(p->opr.oper == VEC_NE)
+                            result.data.bool = !result.data.bool;
                         return result;
                     }
 
-                    case LE:
+                    case INT_PRINT:
                     {
-                        /* evaluate the operands */
-                        payload *op1 = interpret(p->opr.op[0]);
-                        payload *op2 = interpret(p->opr.op[1]);
-                        payload *result = NULL;
-                        
-                        if(op1->type == typeNumConstant)
-                        {
-                            if(op2->type == typeVecConstant)
-                                yyerror("Incompatible types: vector and a scalar.");
+                        payload toPrint = interpret(p->opr.op[0]);
+                        payload res = newResult(typeBool);
 
-                            /* set typeBool as the return type */
-                            result = newResult(typeBool);
-                            /* do the actual calculations */
-                            result->data.bool = op1->data.number <= op2->data.number;
-                        }
-                        else
-                            yyerror("Incompatible types: operation can't be performed on vectors.");
+                        if(toPrint.type != typeIntConstant)
+                            return deoptimise(p, toPrint, toPrint);
 
-                        assert(result);
+                        if(p->opr.op[0]->type == typeId)
+                            fprintf(dataFile, "%s = ", p->opr.op[0]->id.id);
+                        res.data.bool = fprintf(dataFile, INT64_FORMAT "\n", toPrint.data.integer);
+                        return res;
+                    }
+
+                    case INT_ASSIGN:
+                    {
+                        payload rhs = interpret(p->opr.op[1]);
+                        payload result = newResult(typeBool);
+
+                        if(rhs.type != typeIntConstant)
+                            return deoptimise(p, result, rhs);
+                        p->opr.op[0]->id.symbol->data.integer = rhs.data.integer;
+                        result.data.bool = 1;
                         return result;
                     }
 
-                    case NE:
+                    case INT_NEG:
                     {
-                        /* evaluate the operands */
-                        payload *op1 = interpret(p->opr.op[0]);
-                        payload *op2 = interpret(p->opr.op[1]);
-                        payload *result = NULL;
+                        payload result = interpret(p->opr.op[0]);
+                        if(result.type != typeIntConstant)
+                            return deoptimise(p, result, result);
+                        result.data.integer = INTEGER_NEG(result.data.integer);
+                        return result;
+                    }
 
-                        /* test if the types match */
-                        if(op1->type != op2->type)
-                            yyerror("Incompatible types: vector and a scalar.");
-                        
-                        /* decide if we're performing vector or scalar addition */
-                        switch(op1->type)
+                    case INT_ADD:
+                    case INT_SUB:
+                    case INT_MUL:
+                    case INT_DIV:
+                    {
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        int64 i1 = op1.data.integer, i2 = op2.data.integer;
+
+                        if(op1.type != typeIntConstant || op2.type != typeIntConstant)
+                            return deoptimise(p, op1, op2);
+
+                        switch(p->opr.oper)
                         {
-                            case typeVecConstant:
-                                /* set typeBool as the return type */
-                                result = newResult(typeBool);
-                                /* do the actual calculations */
-                                if(vectorCompare(op1->data.vector, op2->data.vector))
-                                    result->data.bool = 0;
-                                else
-                                    result->data.bool = 1;
-                                break;
-                            case typeNumConstant:
-                                /* set typeNumConstant as the return type */
-                                result = newResult(typeBool);
-                                /* do the actual calculations */
-                                if(numberCompare(op1->data.number, op2->data.number))
-                                    result->data.bool = 0;
-                                else
-                                    result->data.bool = 1;
+                            case INT_ADD: op1.data.integer = INTEGER_ADD(i1, i2); break;
+                            case INT_SUB: op1.data.integer = INTEGER_SUB(i1, i2); break;
+                            case INT_MUL: op1.data.integer = INTEGER_MUL(i1, i2); break;
+                            case INT_DIV:
+                                if(!integerDivide(i1, i2, &op1.data.integer))
+                                {
+                                    yyerror("ERROR: integer division by zero.");
+                                    return newResult(-1);
+                                }
                                 break;
-                            default:
-                                yyerror("Incompatible types: vector and a scalar.");
                         }
-
-                        assert(result);
-                        return result;
+                        return op1;
                     }
 
-                    case EQ:
+                    case INT_LT:
+                    case INT_GT:
+                    case INT_GE:
+                    case INT_LE:
+                    case INT_EQ:
+                    case INT_NE:
                     {
-                        /* evaluate the operands */
-                        payload *op1 = interpret(p->opr.op[0]);
-                        payload *op2 = interpret(p->opr.op[1]);
-                        payload *result = NULL;
+                        payload op1 = interpret(p->opr.op[0]);
+                        payload op2 = interpret(p->opr.op[1]);
+                        payload result = newResult(typeBool);
+                        int64 i1 = op1.data.integer, i2 = op2.data.integer;
 
-                        /* test if the types match */
-                        if(op1->type != op2->type)
-                            yyerror("Incompatible types: vector and a scalar.");
-                        
-                        /* decide if we're performing vector or scalar addition */
-                        switch(op1->type)
+                        if(op1.type != typeIntConstant || op2.type != typeIntConstant)
+                            return deoptimise(p, op1, op2);
+
+                        /* ints are compared exactly */
+                        switch(p->opr.oper)
                         {
-                            case typeVecConstant:
-                                /* set typeBool as the return type */
-                                result = newResult(typeBool);
-                                /* do the actual calculations */
-                                result->data.bool = vectorCompare(op1->data.vector, op2->data.vector);
-                                break;
-                            case typeNumConstant:
-                                /* set typeNumConstant as the return type */
-                                result = newResult(typeBool);
-                                /* do the actual calculations */
-                                result->data.bool = numberCompare(op1->data.number, op2->data.number);
-                                break;
-                            default:
-                                yyerror("Incompatible types: vector and a scalar.");
+                            case INT_LT: result.data.bool = i1 < i2; break;
+                            case INT_GT: result.data.bool = i1 > i2; break;
+                            case INT_GE: result.data.bool = i1 >= i2; break;
+                            case INT_LE: result.data.bool = i1 <= i2; break;
+                            case INT_EQ: result.data.bool = i1 == i2; break;
+                            case INT_NE: result.data.bool = i1 != i2; break;
                         }
+                        return result;
+                    }
+
+                    default:
+                    {
+                        /* the operands of the generic operators are
+                           evaluated first, in order; the variable of an
+                           assignment is written, not read */
+                        payload op1 = newResult(-1), op2 = newResult(-1), result;
+
+                        if(p->opr.oper != '=')
+                            op1 = interpret(p->opr.op[0]);
+                        if(p->opr.nops > 1)
+                            op2 = interpret(p->opr.op[1]);
+
+                        result = evaluateOperator(p, op1, op2);
 
-                        assert(result);
+                        /* the next time, it runs as the specialised one */
+                        if(quickeningEnabled)
+                            quicken(p, op1.type, op2.type);
                         return result;
+                    }
                 }
+        }
+    }
+    assert(!"Interpretting didn't match any rules");
+    return newResult(-1);
+}
+
+/* Applies a generic operator to the values of its operands, reporting
+   any type error as it goes. */
+payload evaluateOperator(nodeType* p, payload op1, payload op2)
+{
+    /* an operand has run into a run-time error, which stops the
+       statement */
+    if(errorCount != statementErrors)
+        return newResult(-1);
+
+    if(IS_ARRAY(op1.type) || IS_ARRAY(op2.type))
+        return evaluateArray(p, op1, op2);
+
+    if(IS_VECTOR_N(op1.type) || IS_VECTOR_N(op2.type))
+        return evaluateVectorN(p, op1, op2);
+
+    /* the type checker sees to it that an int only meets another int */
+    if(op1.type == typeIntConstant || op2.type == typeIntConstant)
+        return evaluateInteger(p, op1, op2);
+
+    switch(p->opr.oper)
+    {
+        case PRINT:
+        {
+            payload res;
+			payload toPrint;
+			
+			res = newResult(typeBool);
+
+            if(p->opr.op[0]->type == typeId)
+                fprintf(dataFile, "%s = ", p->opr.op[0]->id.id);
+
+			toPrint = op1;
+
+            switch(toPrint.type)
+            {
+                case typeVecConstant:
+                    res.data.bool = fprintf(dataFile, VECTOR_FORMAT "\n",
+                                            toPrint.data.vector.x,
+                                            toPrint.data.vector.y,
+                                            toPrint.data.vector.z);
+                break;
+                case typeNumConstant:
+                    res.data.bool = fprintf(dataFile, NUMBER_FORMAT "\n", toPrint.data.number);
+                break;
+                default:
+                    yyerror("Wrong argument for printing.");
             }
+            return res;
+        }
+            
+        case '=':
+        {
+            /* all control statements return 0 */
+            payload result = newResult(typeBool);
+            nodeType *lhs = p->opr.op[0];
+            symbolEntry *symbol = lhs->id.symbol;
+            payload rhs = op2;
+            
+
+            /* Very simple type-checking */
+            if(symbol && lhs->id.idType != rhs.type)
+                yyerror("ERROR: Incompatible types to assign.");
+            
+            /* assigning to an undeclared variable does nothing */
+            result.data.bool = symbol != NULL;
+            if(symbol)
+                switch(rhs.type)
+                {
+                    case typeVecConstant:
+                        /* the vector is copied into the variable */
+                        symbol->data.vector = rhs.data.vector;
+                        break;
+                    case typeNumConstant:
+                        symbol->data.number = rhs.data.number;
+                        break;
+                }
+            return result;
+        }
+
+        case UMINUS:
+        {
+            payload operand = op1;
+            /* stays invalid unless the operands are right */
+            payload result = newResult(-1);
+            switch(operand.type)
+            {
+                case typeVecConstant:
+                    result = newResult(typeVecConstant);
+                    vectorNeg(&operand.data.vector, &result.data.vector);
+                    break;
+                case typeNumConstant:
+                    result = newResult(typeNumConstant);
+                    result.data.number = -operand.data.number;
+                    break;
+                default:
+                    yyerror("Wrong argument for negation.");
+
+            }
+            return result;
+        }
+
+        case '+':
+        {
+            /* stays invalid unless the operands are right */
+            payload result = newResult(-1);
+            
+            /* test if the types match */
+            if(op1.type != op2.type)
+                yyerror("Incompatible types: vector and a scalar.");
+            
+            /* decide if we're performing vector or scalar addition */
+            switch(op1.type)
+            {
+                case typeVecConstant:
+                    /* set VECTOR as the return type */
+                    result = newResult(typeVecConstant);
+                    vectorAdd(&op1.data.vector, &op2.data.vector,
+                              &result.data.vector);
+                    break;
+                case typeNumConstant:
+                    if(op2.type == typeVecConstant)
+                        yyerror("Incompatible types: vector and a scalar.");
+
+                    /* set typeNumConstant as the return type */
+                    result = newResult(typeNumConstant);
+                    /* do the actual calculations */
+                    result.data.number = op1.data.number + op2.data.number;
+                    break;
+                default:
+                    yyerror("Incompatible types: vector and a scalar.");
+            }
+
+            return result;
+        }
+
+        case '-':
+        {
+            /* stays invalid unless the operands are right */
+            payload result = newResult(-1);
+            
+            /* test if the types match */
+            if(op1.type != op2.type)
+                yyerror("Incompatible types: vector and a scalar.");
+            
+            /* decide if we're performing vector or scalar subtraction */
+            switch(op1.type)
+            {
+                case typeVecConstant:
+                    /* set VECTOR as the return type */
+                    result = newResult(typeVecConstant);
+                    vectorSub(&op1.data.vector, &op2.data.vector,
+                              &result.data.vector);
+                    break;
+                case typeNumConstant:
+                    /* set typeNumConstant as the return type */
+                    result = newResult(typeNumConstant);
+                    /* do the actual calculations */
+                    result.data.number = op1.data.number - op2.data.number;
+                    break;
+                default:
+                    yyerror("Incompatible types: vector and a scalar.");
+            }
+
+            return result;
+        }
+
+        case '*':
+        {
+            /* stays invalid unless the operands are right */
+            payload result = newResult(-1);
+            
+            /* decide if we're performing vector or scalar multiplication */
+            switch(op1.type)
+            {
+                case typeNumConstant:
+                    switch(op2.type)
+                    {
+                        case typeNumConstant:
+                            /* set typeNumConstant as the return type */
+                            result = newResult(typeNumConstant);
+                            /* do the actual calculations */
+                            result.data.number = op1.data.number * op2.data.number;
+                            break;
+                        case typeVecConstant:
+                            /* set typeVecConstant as the return type */
+                            result = newResult(typeVecConstant);
+                            vectorScale(&op2.data.vector, op1.data.number,
+                                        &result.data.vector);
+                            break;
+                    }
+                    break;
+                case typeVecConstant:
+                    switch(op2.type)
+                    {
+                        case typeNumConstant:
+                            /* set typeNumConstant as the return type */
+                            result = newResult(typeVecConstant);
+                            /* do the actual calculations */
+                            vectorScale(&op1.data.vector, op2.data.number,
+                                        &result.data.vector);
+                            break;
+                        case typeVecConstant:
+                            yyerror("ERROR: vector multiplication is undefined.");
+                            break;
+                    }
+            }
+
+            return result;
+        }
+
+        case '/':
+        {
+            /* stays invalid unless the operands are right */
+            payload result = newResult(-1);
+            
+            /* decide if we're performing vector or scalar division */
+            switch(op1.type)
+            {
+                case typeNumConstant:
+                    switch(op2.type)
+                    {
+                        case typeNumConstant:
+                            /* set typeNumConstant as the return type */
+                            result = newResult(typeNumConstant);
+                            /* do the actual calculations */
+                            result.data.number = op1.data.number / op2.data.number;
+                            break;
+                        case typeVecConstant:
+                            /* set typeVecConstant as the return type */
+                            result = newResult(typeVecConstant);
+                            vectorScale(&op2.data.vector, 1/op1.data.number,
+                                        &result.data.vector);
+                            break;
+                    }
+                    break;
+                case typeVecConstant:
+                    switch(op2.type)
+                    {
+                        case typeNumConstant:
+                            /* set typeNumConstant as the return type */
+                            result = newResult(typeVecConstant);
+                            /* do the actual calculations */
+                            vectorScale(&op1.data.vector, 1/op2.data.number,
+                                        &result.data.vector);
+                            break;
+                        case typeVecConstant:
+                            yyerror("ERROR: vector multiplication is undefined.");
+                            break;
+                    }
+            }
+            return result;
+        }
+
+        case CROSS:
+        {
+            /* stays invalid unless the operands are right */
+            payload result = newResult(-1);
+            
+            /* cross product is only defined for vectors */
+            if(op1.type == typeNumConstant && op2.type == typeNumConstant)
+                yyerror("Incompatible types: vector and a scalar.");
+
+            /* set typeNumConstant as the return type */
+            result = newResult(typeVecConstant);
+            /* do the actual calculations */
+            vectorCross(&op1.data.vector, &op2.data.vector,
+                        &result.data.vector);
+
+            return result;
+        }
+
+        case DOT:
+        {
+            /* stays invalid unless the operands are right */
+            payload result = newResult(-1);
+            
+            /* cross product is only defined for vectors */
+            if(op1.type == typeNumConstant && op2.type == typeNumConstant)
+                yyerror("Incompatible types: vector and a scalar.");
+
+            /* set typeNumConstant as the return type */
+            result = newResult(typeNumConstant);
+            /* do the actual calculations */
+            result.data.number = vectorDot(&op1.data.vector,
+                                           &op2.data.vector);
+
+            return result;
+        }
+
+        case '<':
+        {
+            /* stays invalid unless the operands are right */
+            payload result = newResult(-1);
+            
+            if(op1.type == typeNumConstant)
+            {
+                if(op2.type == typeVecConstant)
+                    yyerror("Incompatible types: vector and a scalar.");
+
+                /* set typeBool as the return type */
+                result = newResult(typeBool);
+                /* do the actual calculations */
+                result.data.bool = op1.data.number < op2.data.number;
+            }
+            else
+                yyerror("Incompatible types: operation can't be performed on vectors.");
+
+            return result;
+        }
+
+        case '>':
+        {
+            /* stays invalid unless the operands are right */
+            payload result = newResult(-1);
+            
+            if(op1.type == typeNumConstant)
+            {
+                if(op2.type == typeVecConstant)
+                    yyerror("Incompatible types: vector and a scalar.");
+
+                /* set typeBool as the return type */
+                result = newResult(typeBool);
+                /* do the actual calculations */
+                result.data.bool = op1.data.number > op2.data.number;
+            }
+            else
+                yyerror("Incompatible types: operation can't be performed on vectors.");
+
+            return result;
+        }
+
+        case GE:
+        {
+            /* stays invalid unless the operands are right */
+            payload result = newResult(-1);
+            
+            if(op1.type == typeNumConstant)
+            {
+                if(op2.type == typeVecConstant)
+                    yyerror("Incompatible types: vector and a scalar.");
+
+                /* set typeBool as the return type */
+                result = newResult(typeBool);
+                /* do the actual calculations */
+                result.data.bool = op1.data.number >= op2.data.number;
+            }
+            else
+                yyerror("Incompatible types: operation can't be performed on vectors.");
+
+            return result;
+        }
+
+        case LE:
+        {
+            /* stays invalid unless the operands are right */
+            payload result = newResult(-1);
+            
+            if(op1.type == typeNumConstant)
+            {
+                if(op2.type == typeVecConstant)
+                    yyerror("Incompatible types: vector and a scalar.");
+
+                /* set typeBool as the return type */
+                result = newResult(typeBool);
+                /* do the actual calculations */
+                result.data.bool = op1.data.number <= op2.data.number;
+            }
+            else
+                yyerror("Incompatible types: operation can't be performed on vectors.");
+
+            return result;
+        }
+
+        case NE:
+        {
+            /* stays invalid unless the operands are right */
+            payload result = newResult(-1);
+
+            /* test if the types match */
+            if(op1.type != op2.type)
+                yyerror("Incompatible types: vector and a scalar.");
+            
+            /* decide if we're performing vector or scalar addition */
+            switch(op1.type)
+            {
+                case typeVecConstant:
+                    /* set typeBool as the return type */
+                    result = newResult(typeBool);
+                    /* do the actual calculations */
+                    if(vectorCompare(&op1.data.vector, &op2.data.vector))
+                        result.data.bool = 0;
+                    else
+                        result.data.bool = 1;
+                    break;
+                case typeNumConstant:
+                    /* set typeNumConstant as the return type */
+                    result = newResult(typeBool);
+                    /* do the actual calculations */
+                    if(numberCompare(op1.data.number, op2.data.number))
+                        result.data.bool = 0;
+                    else
+                        result.data.bool = 1;
+                    break;
+                default:
+                    yyerror("Incompatible types: vector and a scalar.");
+            }
+
+            return result;
+        }
+
+        case EQ:
+        {
+            /* stays invalid unless the operands are right */
+            payload result = newResult(-1);
+
+            /* test if the types match */
+            if(op1.type != op2.type)
+                yyerror("Incompatible types: vector and a scalar.");
+            
+            /* decide if we're performing vector or scalar addition */
+            switch(op1.type)
+            {
+                case typeVecConstant:
+                    /* set typeBool as the return type */
+                    result = newResult(typeBool);
+                    /* do the actual calculations */
+                    result.data.bool = vectorCompare(&op1.data.vector, &op2.data.vector);
+                    break;
+                case typeNumConstant:
+                    /* set typeNumConstant as the return type */
+                    result = newResult(typeBool);
+                    /* do the actual calculations */
+                    result.data.bool = numberCompare(op1.data.number, op2.data.number);
+                    break;
+                default:
+                    yyerror("Incompatible types: vector and a scalar.");
+            }
+
+            return result;
         }
     }
     assert(!"Interpretting didn't match any rules");
+    return newResult(-1);
+}
+
+/* Applies a generic operator to ints. */
+payload evaluateInteger(nodeType* p, payload op1, payload op2)
+{
+    payload result = newResult(typeBool);
+    int64 i1 = op1.data.integer, i2 = op2.data.integer;
+
+    switch(p->opr.oper)
+    {
+        case PRINT:
+            if(p->opr.op[0]->type == typeId)
+                fprintf(dataFile, "%s = ", p->opr.op[0]->id.id);
+            result.data.bool = fprintf(dataFile, INT64_FORMAT "\n", i1);
+            return result;
+
+        case '=':
+        {
+            symbolEntry *symbol = p->opr.op[0]->id.symbol;
+
+            if(symbol && p->opr.op[0]->id.idType != typeIntConstant)
+                yyerror("ERROR: Incompatible types to assign.");
+            else if(symbol)
+                symbol->data.integer = i2;
+
+            /* assigning to an undeclared variable does nothing */
+            result.data.bool = symbol != NULL;
+            return result;
+        }
+
+        case UMINUS:
+            result = newResult(typeIntConstant);
+            result.data.integer = INTEGER_NEG(i1);
+            return result;
+    }
+
+    if(op1.type != op2.type)
+    {
+        yyerror("Incompatible types: vector and a scalar.");
+        return newResult(-1);
+    }
+
+    switch(p->opr.oper)
+    {
+        case '<':   result.data.bool = i1 < i2; return result;
+        case '>':   result.data.bool = i1 > i2; return result;
+        case GE:    result.data.bool = i1 >= i2; return result;
+        case LE:    result.data.bool = i1 <= i2; return result;
+        case EQ:    result.data.bool = i1 == i2; return result;
+        case NE:    result.data.bool = i1 != i2; return result;
+    }
+
+    result = newResult(typeIntConstant);
+    switch(p->opr.oper)
+    {
+        case '+':   result.data.integer = INTEGER_ADD(i1, i2); break;
+        case '-':   result.data.integer = INTEGER_SUB(i1, i2); break;
+        case '*':   result.data.integer = INTEGER_MUL(i1, i2); break;
+        case '/':
+            if(!integerDivide(i1, i2, &result.data.integer))
+            {
+                yyerror("ERROR: integer division by zero.");
+                return newResult(-1);
+            }
+            break;
+        default:
+            yyerror("Incompatible types: vector and a scalar.");
+            return newResult(-1);
+    }
+    return result;
+}
+
+/* Applies a generic operator with an array operand. */
+payload evaluateArray(nodeType* p, payload op1, payload op2)
+{
+    payload result = newResult(typeBool);
+
+    switch(p->opr.oper)
+    {
+        case PRINT:
+            if(p->opr.op[0]->type == typeId)
+                fprintf(dataFile, "%s = ", p->opr.op[0]->id.id);
+            result.data.bool = printArray(dataFile, op1.data.array);
+            releaseArray(op1.data.array);
+            return result;
+
+        case '=':
+        {
+            symbolEntry *symbol = p->opr.op[0]->id.symbol;
+
+            /* assigning to an undeclared variable does nothing */
+            result.data.bool = symbol != NULL;
+            if(symbol && p->opr.op[0]->id.idType != op2.type)
+                yyerror("ERROR: Incompatible types to assign.");
+            else if(symbol)
+            {
+                /* the assignment uses the value up */
+                assignArray(&symbol->data.array, op2.data.array);
+                return result;
+            }
+            if(IS_ARRAY(op2.type))
+                releaseArray(op2.data.array);
+            return result;
+        }
+
+        case EQ:
+        case NE:
+            result.data.bool = compareArrays(op1.data.array, op2.data.array) ==
+                               (p->opr.oper == EQ);
+            return result;
+    }
+
+    return arrayPayload(arrayOperator(p->opr.oper, op1.type, &op1.data,
+                                      op2.type, &op2.data));
+}
+
+/* Applies a generic operator with a vec2 or vec4 operand. */
+payload evaluateVectorN(nodeType* p, payload op1, payload op2)
+{
+    payload result = newResult(typeBool);
+    symbolEntry *symbol;
+
+    switch(p->opr.oper)
+    {
+        case PRINT:
+            if(p->opr.op[0]->type == typeId)
+                fprintf(dataFile, "%s = ", p->opr.op[0]->id.id);
+            result.data.bool = printVectorN(dataFile, op1.type, &op1.data);
+            return result;
+
+        case '=':
+            symbol = p->opr.op[0]->id.symbol;
+
+            /* assigning to an undeclared variable does nothing */
+            result.data.bool = symbol != NULL;
+            if(symbol && p->opr.op[0]->id.idType != op2.type)
+                yyerror("ERROR: Incompatible types to assign.");
+            else if(symbol && op2.type == typeVec2Constant)
+                symbol->data.vector2 = op2.data.vector2;
+            else if(symbol)
+                symbol->data.vector4 = op2.data.vector4;
+            return result;
+    }
+
+    result.type = vectorNOperator(p->opr.oper, op1.type, &op1.data,
+                                  op2.type, &op2.data, &result.data);
+    return result;
+}
+
+/* The result holding an array, or an invalid one if there is none. */
+payload arrayPayload(vectorArray* array)
+{
+    payload result = newResult(array ? array->type : -1);
+
+    result.data.array = array;
+    return result;
+}
+
+/* Rewrites a generic operator into the one specialised for the types of
+   the operands it has just been given. */
+void quicken(nodeType* p, int t1, int t2)
+{
+    int specialised;
+
+    /* for an assignment, the type of the variable */
+    if(p->opr.oper == '=')
+    {
+        if(!p->opr.op[0]->id.symbol)
+            return;
+        t1 = p->opr.op[0]->id.idType;
+    }
+    /* a unary operator is specialised for its one operand */
+    else if(p->opr.nops == 1)
+        t2 = t1;
+
+    if((specialised = specialisedOperator(p->opr.oper, t1, t2)) != 0)
+        p->opr.oper = specialised;
+}
+
+/* The guard of a specialised operator failed: it goes back to being the
+   generic one, which deals with whatever types the operands have. */
+payload deoptimise(nodeType* p, payload op1, payload op2)
+{
+    p->opr.oper = genericOperator(p->opr.oper);
+    return evaluateOperator(p, op1, op2);
+}
+
+void keepStatement(nodeType* p)
+{
+    if(programCount == programCapacity)
+    {
+        programCapacity = programCapacity ? programCapacity * 2 : 64;
+        if((program = realloc(program, programCapacity * sizeof(nodeType*))) == NULL)
+            yyerror("Out of memory encountered.");
+        assert(program);
+    }
+    program[programCount++] = p;
+
+    /* the statement runs after the parser has moved on */
+    if(p->type == typeOperator)
+        p->opr.line = yylinenum;
+}
+
+void statementLine(nodeType* p)
+{
+    if(p && p->type == typeOperator && p->opr.line)
+        yylinenum = p->opr.line;
+}
+
+void execute(nodeType* p)
+{
+    /* a statement with a type error is not run at all, and the parser
+       runs nothing after it */
+    if(!typeCheck(p))
+        return;
+
+    /* the statements of a whole script are optimised together, once it
+       has been parsed */
+    if(wholeScriptEnabled)
+    {
+        keepStatement(p);
+        return;
+    }
+
+    if(optimiserEnabled)
+        p = optimise(p);
+
+    /* keep the statement until the whole script is known */
+    if(executionMode == modeCompile)
+    {
+        keepStatement(p);
+        return;
+    }
+
+    runStatement(p);
+}
+
+void runStatement(nodeType* p)
+{
+    statementErrors = errorCount;
+
+    switch(executionMode)
+    {
+        case modeTree:
+            /* quickened operators specialise themselves as they run */
+            if(!quickeningEnabled)
+                specialise(p);
+            interpret(p);
+            break;
+
+        case modeLinear:
+        {
+            linearTree *t;
+
+            specialise(p);
+            t = linearise(p);
+            runLinear(t);
+            freeLinear(t);
+            break;
+        }
+
+        case modeBytecode:
+        {
+            chunk *c = compileTree(p);
+            runChunk(c);
+            freeChunk(c);
+            break;
+        }
+
+        case modeClosure:
+        {
+            closure *c = compileClosure(p);
+            runClosure(c);
+            freeClosure(c);
+            break;
+        }
+
+        case modeJit:
+            jitExecute(p);
+            break;
+    }
+
+    /* nothing else refers to the statement's nodes or temporaries */
+    freeNodes();
+    freeTemporaryArrays();
+}
+
+void executeScript(void)
+{
+    nodeType *script = NULL;
+    int i, compiled = 0, errors = errorCount;
+
+    /* the statements kept become the one block of the program, so the
+       optimiser sees across them; it is then run like any statement */
+    if(wholeScriptEnabled && programCount > 0)
+    {
+        for(i = 0; i < programCount; ++i)
+            script = sequence(script, program[i]);
+
+        if(optimiserEnabled)
+            script = optimise(script);
+
+        program[0] = script;
+        programCount = 1;
+
+        if(executionMode != modeCompile)
+            runStatement(script);
+    }
+
+    if(executionMode == modeCompile)
+    {
+        if(errorCount == 0 && programCount > 0)
+            compiled = compileScript(program, programCount, scriptPath);
+
+        /* otherwise run the statements one by one on the virtual machine,
+           stopping at the first error as the parser does */
+        if(!compiled && programCount > 0)
+        {
+            if(errorCount == 0)
+                fprintf(stderr, "Script can't be compiled into C; interpreting it instead.\n");
+
+            executionMode = modeBytecode;
+            for(i = 0; i < programCount && errorCount == errors; ++i)
+            {
+                chunk *c = compileTree(program[i]);
+                statementLine(program[i]);
+                runChunk(c);
+                freeChunk(c);
+                freeTemporaryArrays();
+            }
+        }
+    }
+
+    freeNodes();
+    free(program);
+    program = NULL;
+    programCount = programCapacity = 0;
 }
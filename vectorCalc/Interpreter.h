@@ -7,10 +7,38 @@
 typedef struct {
     int type;                       /* simple typing */
     union {
-        vector3* vector;            /* vector results */
-        double number;              /* for numeric results */
+        vector3 vector;             /* vector results, by value */
+        vec2 vector2;               /* vec2 results, by value */
+        vec4 vector4;               /* vec4 results, by value */
+        real number;                /* for numeric results */
+        int64 integer;              /* for int results */
+        vectorArray* array;         /* for array results */
         int bool;                   /* for true/false results */
     } data;
 } payload;
 
-payload* interpret(nodeType*);
+/* the ways a statement can be executed */
+typedef enum {
+    modeTree,                       /* walk the parse tree (reference) */
+    modeLinear,                     /* walk the linear form of the tree */
+    modeBytecode,                   /* compile to bytecode and run the VM */
+    modeClosure,                    /* compile to closures and call them */
+    modeJit,                        /* compile loops to machine code */
+    modeCompile                     /* translate the script into C */
+} executionModeEnum;
+
+/* Evaluates the tree; the result is returned by value. */
+payload interpret(nodeType*);
+
+/* Executes a statement in the mode selected on the command line and
+   frees it; in compile or whole-script mode the statement is kept for
+   executeScript(). */
+void execute(nodeType*);
+
+/* Makes the line a kept statement ends on the current one, so the
+   errors it reports when it's run later point at it. */
+void statementLine(nodeType*);
+
+/* Called once the whole script is parsed; runs the statements kept in
+   compile or whole-script mode. */
+void executeScript(void);
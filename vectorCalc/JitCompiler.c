@@ -0,0 +1,923 @@
+/*
+   The x86-64 JIT compiler's implementation.
+
+   A statement containing WHILE loops is compiled straight into SSE2
+   machine code. All the variables the statement uses are copied into a
+   fixed frame of doubles before it runs (and back into the symbol table
+   afterwards), so the loops never look a name up; constants and loop
+   flags live in the same frame, addressed off rbx. Expressions are
+   evaluated into xmm registers, a vector taking three consecutive ones;
+   an int is evaluated into a general-purpose register instead, and
+   keeps its 64 bits in its cell of the frame.
+
+   Only statically typed number/vector/int code is compiled - the types
+   come from the constants and the declared variables, and the type
+   checker has already made the int to number conversions explicit.
+   Anything else (a type error, an undeclared variable, an array, a vec2
+   or vec4, an int division, an expression that runs out of registers)
+   makes the compilation fail, and the statement is specialised and
+   handed to interpret() instead. On other platforms, and in the
+   SINGLE_PRECISION build (the generated code works on doubles), every
+   statement is interpreted.
+*/
+
+/* MAP_ANONYMOUS is not part of strict C or POSIX */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "JitCompiler.h"
+#include "Interpreter.h"
+#include "TypeChecker.h"
+#include "SymbolTable.h"
+#include "vectorCalc.tab.h"
+#include "Math.h"
+
+/* The number of errors detected, defined in vectorCalc.y */
+extern int errorCount;
+
+/* The number of errors when the statement started, defined in
+   Interpreter.c */
+extern int statementErrors;
+
+/* functions prototypes */
+int containsLoop(nodeType*);
+int jitRun(nodeType*);
+
+int containsLoop(nodeType* p)
+{
+    int i;
+
+    if(!p || p->type != typeOperator) return 0;
+    if(p->opr.oper == WHILE) return 1;
+
+    for(i = 0; i < p->opr.nops; ++i)
+        if(containsLoop(p->opr.op[i]))
+            return 1;
+    return 0;
+}
+
+void jitExecute(nodeType* p)
+{
+    int i;
+
+    if(!p) return;
+
+    if(containsLoop(p) && jitRun(p))
+        return;
+
+    /* the statement couldn't be compiled as a whole, but its parts can,
+       up to the first error */
+    if(p->type == typeOperator && (p->opr.oper == ';' || p->opr.oper == SEQUENCE))
+    {
+        for(i = 0; i < p->opr.nops && errorCount == statementErrors; ++i)
+        {
+            statementLine(p->opr.op[i]);
+            jitExecute(p->opr.op[i]);
+        }
+        return;
+    }
+
+    specialise(p);
+    interpret(p);
+}
+
+#if defined(__x86_64__) && defined(__linux__) && !defined(SINGLE_PRECISION)
+
+#include <sys/mman.h>
+
+/* the highest xmm register available for expressions */
+#define LAST_REGISTER 15
+
+/* the highest expression register an int can be evaluated into; see
+   integerRegister() */
+#define LAST_INTEGER_REGISTER 7
+
+/* SSE2 instructions - the prefix and the opcode following 0x0F */
+#define MOVSD_LOAD  0xF2, 0x10
+#define MOVSD_STORE 0xF2, 0x11
+#define MOVAPD      0x66, 0x28
+#define ADDSD       0xF2, 0x58
+#define MULSD       0xF2, 0x59
+#define SUBSD       0xF2, 0x5C
+#define DIVSD       0xF2, 0x5E
+#define UCOMISD     0x66, 0x2E
+
+/* 64-bit integer instructions - op r/m, reg, or reg, r/m for the loads
+   and imul (whose opcode follows 0x0F) */
+#define INT_ADD_OP   0x01
+#define INT_SUB_OP   0x29
+#define INT_CMP_OP   0x39
+#define INT_STORE_OP 0x89
+#define INT_LOAD_OP  0x8B
+#define INT_IMUL_OP  0x0FAF
+
+/* condition codes for setcc and jcc */
+#define CC_AE 0x3
+#define CC_E  0x4
+#define CC_NE 0x5
+#define CC_A  0x7
+#define CC_L  0xC
+#define CC_GE 0xD
+#define CC_LE 0xE
+#define CC_G  0xF
+
+/* An 8-byte cell of the frame. */
+typedef struct {
+    symbolEntry* symbol;        /* the variable; NULL if not a variable */
+    int type;                   /* type of the variable or constant */
+    double value;               /* value of a constant */
+    int64 integer;              /* value of an int constant */
+} jitSlot;
+
+/* The state of a single compilation. */
+typedef struct {
+    unsigned char* code;        /* machine code */
+    int size, capacity;
+    jitSlot* slots;             /* the frame */
+    int slotCount, slotCapacity;
+    int failed;                 /* set when something can't be compiled */
+} jitState;
+
+/* The output file defined in main.c */
+extern FILE *dataFile;
+
+/* functions prototypes */
+void emitByte(jitState*, int);
+void emit32(jitState*, int);
+void emit64(jitState*, void*);
+void emitSse(jitState*, int, int, int, int);
+void emitSseSlot(jitState*, int, int, int, int);
+void emitInteger(jitState*, int, int, int);
+void emitIntegerSlot(jitState*, int, int, int);
+int integerRegister(int);
+int addSlot(jitState*, symbolEntry*, int, double);
+int addVariable(jitState*, symbolEntry*, int);
+int addConstant(jitState*, double);
+int addIntegerConstant(jitState*, int64);
+int useRegisters(jitState*, int);
+int useIntegerRegisters(jitState*, int);
+int genIntegerOperator(jitState*, nodeType*, int);
+int sizeOf(int);
+int genExpression(jitState*, nodeType*, int);
+void genCondition(jitState*, nodeType*);
+void genStatement(jitState*, nodeType*);
+int genJump(jitState*, int);
+void patchJump(jitState*, int);
+void jitPrintNumber(double, char*);
+void jitPrintVector(double, double, double, char*);
+void jitPrintInteger(int64, char*);
+
+void emitByte(jitState* s, int byte)
+{
+    if(s->size == s->capacity)
+    {
+        s->capacity = s->capacity ? s->capacity * 2 : 256;
+        if((s->code = realloc(s->code, s->capacity)) == NULL)
+            yyerror("Out of memory encountered.");
+        assert(s->code);
+    }
+    s->code[s->size++] = (unsigned char)byte;
+}
+
+void emit32(jitState* s, int value)
+{
+    int i;
+    for(i = 0; i < 4; ++i)
+        emitByte(s, (value >> (8 * i)) & 0xFF);
+}
+
+void emit64(jitState* s, void* pointer)
+{
+    unsigned long long value = (unsigned long long)(size_t)pointer;
+    int i;
+    for(i = 0; i < 8; ++i)
+        emitByte(s, (int)((value >> (8 * i)) & 0xFF));
+}
+
+/* op xmm(dst), xmm(src) */
+void emitSse(jitState* s, int prefix, int opcode, int dst, int src)
+{
+    emitByte(s, prefix);
+    if(dst >= 8 || src >= 8)
+        emitByte(s, 0x40 | (dst >= 8 ? 4 : 0) | (src >= 8 ? 1 : 0));
+    emitByte(s, 0x0F);
+    emitByte(s, opcode);
+    emitByte(s, 0xC0 | ((dst & 7) << 3) | (src & 7));
+}
+
+/* op xmm(reg), [rbx + 8 * slot] */
+void emitSseSlot(jitState* s, int prefix, int opcode, int reg, int slot)
+{
+    emitByte(s, prefix);
+    if(reg >= 8)
+        emitByte(s, 0x44);
+    emitByte(s, 0x0F);
+    emitByte(s, opcode);
+    emitByte(s, 0x80 | ((reg & 7) << 3) | 3);
+    emit32(s, slot * 8);
+}
+
+/* op reg, reg - either order, as the opcode has it */
+void emitInteger(jitState* s, int opcode, int reg, int rm)
+{
+    emitByte(s, 0x48 | (reg >= 8 ? 4 : 0) | (rm >= 8 ? 1 : 0));
+    if(opcode > 0xFF)
+        emitByte(s, opcode >> 8);
+    emitByte(s, opcode & 0xFF);
+    emitByte(s, 0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+/* op reg, [rbx + 8 * slot] or the other way round */
+void emitIntegerSlot(jitState* s, int opcode, int reg, int slot)
+{
+    emitByte(s, 0x48 | (reg >= 8 ? 4 : 0));
+    emitByte(s, opcode);
+    emitByte(s, 0x80 | ((reg & 7) << 3) | 3);
+    emit32(s, slot * 8);
+}
+
+/* the general-purpose register an int evaluated into expression register
+   r lives in: rcx, rdx, rsi, rdi and r8 to r11 - none of them has to be
+   preserved, and rax is left for the conditions */
+int integerRegister(int r)
+{
+    static const int registers[LAST_INTEGER_REGISTER + 1] = {
+        1, 2, 6, 7, 8, 9, 10, 11
+    };
+
+    return registers[r];
+}
+
+int addSlot(jitState* s, symbolEntry* symbol, int type, double value)
+{
+    if(s->slotCount == s->slotCapacity)
+    {
+        s->slotCapacity = s->slotCapacity ? s->slotCapacity * 2 : 32;
+        if((s->slots = realloc(s->slots, s->slotCapacity * sizeof(jitSlot))) == NULL)
+            yyerror("Out of memory encountered.");
+        assert(s->slots);
+    }
+    s->slots[s->slotCount].symbol = symbol;
+    s->slots[s->slotCount].type = type;
+    s->slots[s->slotCount].value = value;
+    s->slots[s->slotCount].integer = 0;
+    return s->slotCount++;
+}
+
+/* returns the first slot of the variable, giving it a place in the frame
+   on the first reference */
+int addVariable(jitState* s, symbolEntry* symbol, int type)
+{
+    int i;
+
+    for(i = 0; i < s->slotCount; ++i)
+        if(s->slots[i].symbol && s->slots[i].symbol == symbol)
+        {
+            if(s->slots[i].type != type)
+                s->failed = 1;
+            return i;
+        }
+
+    /* only the declared variables of the right type are compiled */
+    if(!symbol || symbol->type != type ||
+       (type != typeNumConstant && type != typeVecConstant &&
+        type != typeIntConstant))
+    {
+        s->failed = 1;
+        return 0;
+    }
+
+    i = addSlot(s, symbol, type, 0);
+    if(type == typeVecConstant)
+    {
+        addSlot(s, NULL, -1, 0);
+        addSlot(s, NULL, -1, 0);
+    }
+    return i;
+}
+
+int addConstant(jitState* s, double value)
+{
+    return addSlot(s, NULL, typeNumConstant, value);
+}
+
+int addIntegerConstant(jitState* s, int64 value)
+{
+    int slot = addSlot(s, NULL, typeIntConstant, 0);
+
+    s->slots[slot].integer = value;
+    return slot;
+}
+
+/* checks the expression still fits into the registers */
+int useRegisters(jitState* s, int last)
+{
+    if(last > LAST_REGISTER)
+        s->failed = 1;
+    return !s->failed;
+}
+
+/* checks an int still fits into the general-purpose registers */
+int useIntegerRegisters(jitState* s, int last)
+{
+    if(last > LAST_INTEGER_REGISTER)
+        s->failed = 1;
+    return !s->failed;
+}
+
+int sizeOf(int type)
+{
+    return type == typeVecConstant ? 3 : 1;
+}
+
+/* evaluates the expression into xmm(r) onwards; returns its type */
+int genExpression(jitState* s, nodeType* p, int r)
+{
+    int t1, t2, r2, slot, i;
+
+    if(!p || s->failed)
+    {
+        s->failed = 1;
+        return -1;
+    }
+
+    switch(p->type)
+    {
+        case typeNumConstant:
+            if(!useRegisters(s, r)) return -1;
+            emitSseSlot(s, MOVSD_LOAD, r, addConstant(s, p->con.data.number));
+            return typeNumConstant;
+
+        case typeVecConstant:
+            if(!useRegisters(s, r + 2)) return -1;
+            emitSseSlot(s, MOVSD_LOAD, r, addConstant(s, p->con.data.vector.x));
+            emitSseSlot(s, MOVSD_LOAD, r + 1, addConstant(s, p->con.data.vector.y));
+            emitSseSlot(s, MOVSD_LOAD, r + 2, addConstant(s, p->con.data.vector.z));
+            return typeVecConstant;
+
+        case typeIntConstant:
+            if(!useIntegerRegisters(s, r)) return -1;
+            emitIntegerSlot(s, INT_LOAD_OP, integerRegister(r),
+                            addIntegerConstant(s, p->con.data.integer));
+            return typeIntConstant;
+
+        case typeId:
+            slot = addVariable(s, p->id.symbol, p->id.idType);
+            if(p->id.idType == typeIntConstant)
+            {
+                if(!useIntegerRegisters(s, r)) return -1;
+                emitIntegerSlot(s, INT_LOAD_OP, integerRegister(r), slot);
+                return typeIntConstant;
+            }
+            if(!useRegisters(s, r + sizeOf(p->id.idType) - 1)) return -1;
+            for(i = 0; i < sizeOf(p->id.idType); ++i)
+                emitSseSlot(s, MOVSD_LOAD, r + i, slot + i);
+            return p->id.idType;
+
+        case typeOperator:
+            break;
+
+        default:
+            s->failed = 1;
+            return -1;
+    }
+
+    /* an int used as a number: cvtsi2sd xmm(r), reg */
+    if(p->opr.oper == TO_NUMBER)
+    {
+        t1 = genExpression(s, p->opr.op[0], r);
+        if(s->failed || t1 != typeIntConstant || !useRegisters(s, r)) return -1;
+        emitByte(s, 0xF2);
+        emitByte(s, 0x48 | (r >= 8 ? 4 : 0) | (integerRegister(r) >= 8 ? 1 : 0));
+        emitByte(s, 0x0F);
+        emitByte(s, 0x2A);
+        emitByte(s, 0xC0 | ((r & 7) << 3) | (integerRegister(r) & 7));
+        return typeNumConstant;
+    }
+
+    if(p->opr.oper == UMINUS)
+    {
+        t1 = genExpression(s, p->opr.op[0], r);
+        if(s->failed) return -1;
+        if(t1 == typeIntConstant)
+        {
+            /* neg reg, which wraps around like INTEGER_NEG */
+            emitByte(s, 0x48 | (integerRegister(r) >= 8 ? 1 : 0));
+            emitByte(s, 0xF7);
+            emitByte(s, 0xD8 | (integerRegister(r) & 7));
+            return typeIntConstant;
+        }
+        /* multiply by -1, so that zero becomes -0 just like in C */
+        slot = addConstant(s, -1);
+        for(i = 0; i < sizeOf(t1); ++i)
+            emitSseSlot(s, MULSD, r + i, slot);
+        return t1;
+    }
+
+    switch(p->opr.oper)
+    {
+        case '+': case '-': case '*': case '/': case CROSS: case DOT:
+            break;
+        default:
+            /* comparisons are only compiled as conditions */
+            s->failed = 1;
+            return -1;
+    }
+
+    t1 = genExpression(s, p->opr.op[0], r);
+    r2 = r + sizeOf(t1);
+    t2 = genExpression(s, p->opr.op[1], r2);
+    if(s->failed) return -1;
+
+    if(t1 == typeIntConstant && t2 == typeIntConstant)
+        return genIntegerOperator(s, p, r);
+
+    if(t1 == typeNumConstant && t2 == typeNumConstant)
+    {
+        switch(p->opr.oper)
+        {
+            case '+': emitSse(s, ADDSD, r, r2); return typeNumConstant;
+            case '-': emitSse(s, SUBSD, r, r2); return typeNumConstant;
+            case '*': emitSse(s, MULSD, r, r2); return typeNumConstant;
+            case '/': emitSse(s, DIVSD, r, r2); return typeNumConstant;
+        }
+    }
+    else if(t1 == typeVecConstant && t2 == typeVecConstant)
+    {
+        switch(p->opr.oper)
+        {
+            case '+':
+                for(i = 0; i < 3; ++i)
+                    emitSse(s, ADDSD, r + i, r2 + i);
+                return typeVecConstant;
+
+            case '-':
+                for(i = 0; i < 3; ++i)
+                    emitSse(s, SUBSD, r + i, r2 + i);
+                return typeVecConstant;
+
+            case DOT:
+                for(i = 0; i < 3; ++i)
+                    emitSse(s, MULSD, r + i, r2 + i);
+                emitSse(s, ADDSD, r, r + 1);
+                emitSse(s, ADDSD, r, r + 2);
+                return typeNumConstant;
+
+            case CROSS:
+            {
+                /* a is in r..r+2, b in r+3..r+5; the components are
+                   built in r+6..r+8, with r+9 as the scratch */
+                static const int first[3][4] = {
+                    { 1, 2, 2, 1 }, { 2, 0, 0, 2 }, { 0, 1, 1, 0 }
+                };
+                int t = r + 9;
+
+                if(!useRegisters(s, t)) return -1;
+                for(i = 0; i < 3; ++i)
+                {
+                    emitSse(s, MOVAPD, r + 6 + i, r + first[i][0]);
+                    emitSse(s, MULSD, r + 6 + i, r2 + first[i][1]);
+                    emitSse(s, MOVAPD, t, r + first[i][2]);
+                    emitSse(s, MULSD, t, r2 + first[i][3]);
+                    emitSse(s, SUBSD, r + 6 + i, t);
+                }
+                for(i = 0; i < 3; ++i)
+                    emitSse(s, MOVAPD, r + i, r + 6 + i);
+                return typeVecConstant;
+            }
+        }
+    }
+    else if(t1 == typeVecConstant && t2 == typeNumConstant &&
+            (p->opr.oper == '*' || p->opr.oper == '/'))
+    {
+        int scale = r2;
+
+        /* division scales by the reciprocal, as vectorScale(v, 1/n) */
+        if(p->opr.oper == '/')
+        {
+            scale = r2 + 1;
+            if(!useRegisters(s, scale)) return -1;
+            emitSseSlot(s, MOVSD_LOAD, scale, addConstant(s, 1));
+            emitSse(s, DIVSD, scale, r2);
+        }
+        for(i = 0; i < 3; ++i)
+            emitSse(s, MULSD, r + i, scale);
+        return typeVecConstant;
+    }
+    else if(t1 == typeNumConstant && t2 == typeVecConstant &&
+            (p->opr.oper == '*' || p->opr.oper == '/'))
+    {
+        int scale = r;
+
+        if(p->opr.oper == '/')
+        {
+            scale = r2 + 3;
+            if(!useRegisters(s, scale)) return -1;
+            emitSseSlot(s, MOVSD_LOAD, scale, addConstant(s, 1));
+            emitSse(s, DIVSD, scale, r);
+        }
+        for(i = 0; i < 3; ++i)
+            emitSse(s, MULSD, r2 + i, scale);
+        for(i = 0; i < 3; ++i)
+            emitSse(s, MOVAPD, r + i, r2 + i);
+        return typeVecConstant;
+    }
+
+    /* a type error - leave it for interpret() to report */
+    s->failed = 1;
+    return -1;
+}
+
+/* combines the ints in expression registers r and r + 1 into r; the
+   arithmetic wraps around just like INTEGER_ADD and the others */
+int genIntegerOperator(jitState* s, nodeType* p, int r)
+{
+    int a = integerRegister(r), b = integerRegister(r + 1);
+
+    switch(p->opr.oper)
+    {
+        case '+': emitInteger(s, INT_ADD_OP, b, a); return typeIntConstant;
+        case '-': emitInteger(s, INT_SUB_OP, b, a); return typeIntConstant;
+        case '*': emitInteger(s, INT_IMUL_OP, a, b); return typeIntConstant;
+    }
+
+    /* a division by zero is a run-time error, which is left to
+       interpret() to report */
+    s->failed = 1;
+    return -1;
+}
+
+/* evaluates the comparison into al */
+void genCondition(jitState* s, nodeType* p)
+{
+    int t1, t2, epsilon, i;
+
+    if(!p || p->type != typeOperator)
+    {
+        s->failed = 1;
+        return;
+    }
+
+    switch(p->opr.oper)
+    {
+        case '<': case '>': case GE: case LE: case EQ: case NE:
+            break;
+        default:
+            s->failed = 1;
+            return;
+    }
+
+    t1 = genExpression(s, p->opr.op[0], 0);
+    t2 = genExpression(s, p->opr.op[1], sizeOf(t1));
+    if(s->failed) return;
+
+    if(t1 != t2 || (t1 == typeVecConstant && p->opr.oper != EQ && p->opr.oper != NE))
+    {
+        s->failed = 1;
+        return;
+    }
+
+    /* ints are compared exactly: cmp a, b; setcc al */
+    if(t1 == typeIntConstant)
+    {
+        int condition = CC_E;
+
+        switch(p->opr.oper)
+        {
+            case '<': condition = CC_L;  break;
+            case '>': condition = CC_G;  break;
+            case GE:  condition = CC_GE; break;
+            case LE:  condition = CC_LE; break;
+            case NE:  condition = CC_NE; break;
+        }
+        emitInteger(s, INT_CMP_OP, integerRegister(1), integerRegister(0));
+        emitByte(s, 0x0F); emitByte(s, 0x90 | condition); emitByte(s, 0xC0);
+        return;
+    }
+
+    switch(p->opr.oper)
+    {
+        /* unordered operands set CF, so seta/setae are false for NaNs,
+           just like the C comparisons */
+        case '<':
+            emitSse(s, UCOMISD, 1, 0);
+            emitByte(s, 0x0F); emitByte(s, 0x90 | CC_A); emitByte(s, 0xC0);
+            return;
+        case '>':
+            emitSse(s, UCOMISD, 0, 1);
+            emitByte(s, 0x0F); emitByte(s, 0x90 | CC_A); emitByte(s, 0xC0);
+            return;
+        case GE:
+            emitSse(s, UCOMISD, 0, 1);
+            emitByte(s, 0x0F); emitByte(s, 0x90 | CC_AE); emitByte(s, 0xC0);
+            return;
+        case LE:
+            emitSse(s, UCOMISD, 1, 0);
+            emitByte(s, 0x0F); emitByte(s, 0x90 | CC_AE); emitByte(s, 0xC0);
+            return;
+    }
+
+    /* numberCompare(a, b) is EPSILON > b - a; vectors and all components */
+    epsilon = addConstant(s, EPSILON);
+    for(i = 0; i < sizeOf(t1); ++i)
+    {
+        int a = i, b = sizeOf(t1) + i, e = 2 * sizeOf(t1);
+
+        emitSse(s, SUBSD, b, a);
+        emitSseSlot(s, MOVSD_LOAD, e, epsilon);
+        emitSse(s, UCOMISD, e, b);
+        /* seta al for the first component, seta cl; and al, cl for the rest */
+        emitByte(s, 0x0F); emitByte(s, 0x90 | CC_A); emitByte(s, i ? 0xC1 : 0xC0);
+        if(i)
+        {
+            emitByte(s, 0x20); emitByte(s, 0xC8);
+        }
+    }
+    /* xor al, 1 */
+    if(p->opr.oper == NE)
+    {
+        emitByte(s, 0x34); emitByte(s, 0x01);
+    }
+}
+
+/* emits a jcc (or jmp for -1) with the target to be patched later;
+   returns the position of the displacement */
+int genJump(jitState* s, int condition)
+{
+    if(condition < 0)
+        emitByte(s, 0xE9);
+    else
+    {
+        emitByte(s, 0x0F);
+        emitByte(s, 0x80 | condition);
+    }
+    emit32(s, 0);
+    return s->size - 4;
+}
+
+/* points the jump at the current position */
+void patchJump(jitState* s, int at)
+{
+    int rel = s->size - (at + 4);
+    memcpy(s->code + at, &rel, 4);
+}
+
+void jitPrintNumber(double number, char* name)
+{
+    if(name)
+        fprintf(dataFile, "%s = ", name);
+    fprintf(dataFile, NUMBER_FORMAT "\n", number);
+}
+
+void jitPrintVector(double x, double y, double z, char* name)
+{
+    if(name)
+        fprintf(dataFile, "%s = ", name);
+    fprintf(dataFile, VECTOR_FORMAT "\n", x, y, z);
+}
+
+void jitPrintInteger(int64 integer, char* name)
+{
+    if(name)
+        fprintf(dataFile, "%s = ", name);
+    fprintf(dataFile, INT64_FORMAT "\n", integer);
+}
+
+void genStatement(jitState* s, nodeType* p)
+{
+    int type, slot, i;
+
+    if(!p || s->failed) return;
+
+    if(p->type != typeOperator)
+    {
+        genExpression(s, p, 0);
+        return;
+    }
+
+    switch(p->opr.oper)
+    {
+        case ';':
+        case SEQUENCE:
+            for(i = 0; i < p->opr.nops; ++i)
+                genStatement(s, p->opr.op[i]);
+            return;
+
+        case '=':
+        {
+            nodeType *lhs = p->opr.op[0];
+
+            slot = addVariable(s, lhs->id.symbol, lhs->id.idType);
+            type = genExpression(s, p->opr.op[1], 0);
+            if(s->failed) return;
+            if(type != lhs->id.idType)
+            {
+                s->failed = 1;
+                return;
+            }
+            if(type == typeIntConstant)
+            {
+                emitIntegerSlot(s, INT_STORE_OP, integerRegister(0), slot);
+                return;
+            }
+            for(i = 0; i < sizeOf(type); ++i)
+                emitSseSlot(s, MOVSD_STORE, i, slot + i);
+            return;
+        }
+
+        case PRINT:
+        {
+            nodeType *toPrint = p->opr.op[0];
+
+            type = genExpression(s, toPrint, 0);
+            if(s->failed) return;
+            if(type == typeIntConstant)
+            {
+                /* mov rsi, name; mov rdi, the int */
+                emitByte(s, 0x48); emitByte(s, 0xBE);
+                emit64(s, toPrint->type == typeId ? toPrint->id.id : NULL);
+                emitInteger(s, INT_STORE_OP, integerRegister(0), 7);
+                emitByte(s, 0x48); emitByte(s, 0xB8);
+                emit64(s, (void*)jitPrintInteger);
+                emitByte(s, 0xFF); emitByte(s, 0xD0);
+                return;
+            }
+            /* mov rdi, name */
+            emitByte(s, 0x48); emitByte(s, 0xBF);
+            emit64(s, toPrint->type == typeId ? toPrint->id.id : NULL);
+            /* mov rax, handler; call rax - the stack is aligned by push rbx */
+            emitByte(s, 0x48); emitByte(s, 0xB8);
+            if(type == typeVecConstant)
+                emit64(s, (void*)jitPrintVector);
+            else
+                emit64(s, (void*)jitPrintNumber);
+            emitByte(s, 0xFF); emitByte(s, 0xD0);
+            return;
+        }
+
+        case IF:
+        {
+            int otherwise, end;
+
+            genCondition(s, p->opr.op[0]);
+            /* test al, al */
+            emitByte(s, 0x84); emitByte(s, 0xC0);
+            otherwise = genJump(s, CC_E);
+            genStatement(s, p->opr.op[1]);
+
+            /* this can be an if-else */
+            if(p->opr.nops > 2)
+            {
+                end = genJump(s, -1);
+                patchJump(s, otherwise);
+                genStatement(s, p->opr.op[2]);
+                patchJump(s, end);
+            }
+            else
+                patchJump(s, otherwise);
+            return;
+        }
+
+        case WHILE:
+        {
+            int done, loop, back, flag = addSlot(s, NULL, typeBool, 0);
+
+            genCondition(s, p->opr.op[0]);
+            emitByte(s, 0x84); emitByte(s, 0xC0);
+            done = genJump(s, CC_E);
+
+            /* the condition is re-evaluated before each pass of the body,
+               exactly as interpret() does, and kept in the frame */
+            loop = s->size;
+            genCondition(s, p->opr.op[0]);
+            /* movzx eax, al; mov [rbx + flag], rax */
+            emitByte(s, 0x0F); emitByte(s, 0xB6); emitByte(s, 0xC0);
+            emitByte(s, 0x48); emitByte(s, 0x89); emitByte(s, 0x83); emit32(s, flag * 8);
+            genStatement(s, p->opr.op[1]);
+            /* mov rax, [rbx + flag]; test rax, rax; jnz loop */
+            emitByte(s, 0x48); emitByte(s, 0x8B); emitByte(s, 0x83); emit32(s, flag * 8);
+            emitByte(s, 0x48); emitByte(s, 0x85); emitByte(s, 0xC0);
+            back = genJump(s, CC_NE);
+            i = loop - (back + 4);
+            memcpy(s->code + back, &i, 4);
+            patchJump(s, done);
+            return;
+        }
+
+        case '<': case '>': case GE: case LE: case EQ: case NE:
+            genCondition(s, p);
+            return;
+
+        default:
+            genExpression(s, p, 0);
+    }
+}
+
+int jitRun(nodeType* p)
+{
+    jitState s;
+    double *frame;
+    void *memory;
+    int i;
+
+    memset(&s, 0, sizeof(s));
+
+    /* push rbx; mov rbx, rdi */
+    emitByte(&s, 0x53);
+    emitByte(&s, 0x48); emitByte(&s, 0x89); emitByte(&s, 0xFB);
+    genStatement(&s, p);
+    /* pop rbx; ret */
+    emitByte(&s, 0x5B);
+    emitByte(&s, 0xC3);
+
+    if(s.failed)
+    {
+        free(s.code);
+        free(s.slots);
+        return 0;
+    }
+
+    /* copy the code into executable memory */
+    memory = mmap(NULL, s.size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED)
+    {
+        free(s.code);
+        free(s.slots);
+        return 0;
+    }
+    memcpy(memory, s.code, s.size);
+    mprotect(memory, s.size, PROT_READ | PROT_EXEC);
+
+    /* fill the frame with the constants and the current variable values */
+    if((frame = (double*)calloc(s.slotCount + 1, sizeof(double))) == NULL)
+        yyerror("Out of memory encountered.");
+    assert(frame);
+
+    for(i = 0; i < s.slotCount; ++i)
+    {
+        jitSlot *slot = &s.slots[i];
+
+        if(!slot->symbol)
+        {
+            /* the y and z cells of a vector variable are filled below */
+            if(slot->type == typeIntConstant)
+                memcpy(&frame[i], &slot->integer, sizeof(int64));
+            else if(slot->type != -1)
+                frame[i] = slot->value;
+        }
+        else if(slot->type == typeNumConstant)
+            frame[i] = slot->symbol->data.number;
+        else if(slot->type == typeIntConstant)
+            memcpy(&frame[i], &slot->symbol->data.integer, sizeof(int64));
+        else
+        {
+            vector3 *vector = &slot->symbol->data.vector;
+            frame[i] = vector->x;
+            frame[i + 1] = vector->y;
+            frame[i + 2] = vector->z;
+            i += 2;
+        }
+    }
+
+    ((void (*)(double*))memory)(frame);
+
+    /* write the variables back */
+    for(i = 0; i < s.slotCount; ++i)
+    {
+        jitSlot *slot = &s.slots[i];
+
+        if(!slot->symbol)
+            continue;
+        else if(slot->type == typeNumConstant)
+            slot->symbol->data.number = frame[i];
+        else if(slot->type == typeIntConstant)
+            memcpy(&slot->symbol->data.integer, &frame[i], sizeof(int64));
+        else
+        {
+            vector3 *vector = &slot->symbol->data.vector;
+            vector->x = frame[i];
+            vector->y = frame[i + 1];
+            vector->z = frame[i + 2];
+        }
+    }
+
+    munmap(memory, s.size);
+    free(frame);
+    free(s.code);
+    free(s.slots);
+    return 1;
+}
+
+#else
+
+/* no JIT on this platform or precision - everything is interpreted */
+int jitRun(nodeType* p)
+{
+    (void)p;
+    return 0;
+}
+
+#endif
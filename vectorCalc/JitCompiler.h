@@ -0,0 +1,10 @@
+/*
+   Prototype functions for the x86-64 JIT compiler.
+*/
+
+#include "ParseTree.h"
+
+/* Runs the statement, compiling its WHILE loops into machine code when
+   they consist of number/vector/int arithmetic, comparisons, assignments
+   and prints; everything else falls back to interpret(). */
+void jitExecute(nodeType*);
@@ -0,0 +1,589 @@
+/*
+   The linear tree's implementation.
+
+   A statement is laid out once it has been type-checked and specialised,
+   so apart from the control statements, blocks, int to number
+   conversions, assignments to undeclared variables and the operators of
+   arrays, vec2 and vec4, every operator in it is one of the specialised
+   ones and the walker never looks at the types of the values.
+*/
+
+#include <stdio.h>
+#include <assert.h>
+#include "LinearTree.h"
+#include "Interpreter.h"
+#include "SymbolTable.h"
+#include "vectorCalc.tab.h"
+#include "Math.h"
+#include "Array.h"
+#include "VectorN.h"
+
+/* The output file defined in main.c */
+extern FILE *dataFile;
+
+/* The number of errors detected, defined in vectorCalc.y */
+extern int errorCount;
+
+/* The number of errors when the statement started, defined in
+   Interpreter.c */
+extern int statementErrors;
+
+/* The current line, defined in vectorCalc.l */
+extern int yylinenum;
+
+/* functions prototypes */
+void* growArray(void*, int*, size_t);   /* defined in BytecodeCompiler.c */
+uint32_t addLinearNode(linearTree*, int, int, uint32_t, uint32_t);
+uint32_t lineariseNode(linearTree*, nodeType*);
+payload runLinearNode(linearTree*, uint32_t);
+payload arrayPayload(vectorArray*);     /* defined in Interpreter.c */
+
+uint32_t addLinearNode(linearTree* t, int kind, int oper, uint32_t nops, uint32_t arg)
+{
+    if(t->nodeCount == t->nodeCapacity)
+        t->nodes = growArray(t->nodes, &t->nodeCapacity, sizeof(linearNode));
+
+    t->nodes[t->nodeCount].kind = kind;
+    t->nodes[t->nodeCount].oper = oper;
+    t->nodes[t->nodeCount].nops = nops;
+    t->nodes[t->nodeCount].arg = arg;
+    return t->nodeCount++;
+}
+
+/* lays out the operands, then the node; returns the node's index */
+uint32_t lineariseNode(linearTree* t, nodeType* p)
+{
+    uint32_t first, nops, count, i, j;
+
+    if(!p)
+        return addLinearNode(t, typeBool, 0, 0, 0);
+
+    switch(p->type)
+    {
+        case typeNumConstant:
+            if(t->numberCount == t->numberCapacity)
+                t->numbers = growArray(t->numbers, &t->numberCapacity, sizeof(real));
+            t->numbers[t->numberCount] = p->con.data.number;
+            return addLinearNode(t, typeNumConstant, 0, 0, t->numberCount++);
+
+        case typeVecConstant:
+            if(t->vectorCount == t->vectorCapacity)
+                t->vectors = growArray(t->vectors, &t->vectorCapacity, sizeof(vector3));
+            t->vectors[t->vectorCount] = p->con.data.vector;
+            return addLinearNode(t, typeVecConstant, 0, 0, t->vectorCount++);
+
+        case typeVec2Constant:
+            if(t->vector2Count == t->vector2Capacity)
+                t->vectors2 = growArray(t->vectors2, &t->vector2Capacity, sizeof(vec2));
+            t->vectors2[t->vector2Count] = p->con.data.vector2;
+            return addLinearNode(t, typeVec2Constant, 0, 0, t->vector2Count++);
+
+        case typeVec4Constant:
+            if(t->vector4Count == t->vector4Capacity)
+                t->vectors4 = growArray(t->vectors4, &t->vector4Capacity, sizeof(vec4));
+            t->vectors4[t->vector4Count] = p->con.data.vector4;
+            return addLinearNode(t, typeVec4Constant, 0, 0, t->vector4Count++);
+
+        case typeIntConstant:
+            if(t->integerCount == t->integerCapacity)
+                t->integers = growArray(t->integers, &t->integerCapacity, sizeof(int64));
+            t->integers[t->integerCount] = p->con.data.integer;
+            return addLinearNode(t, typeIntConstant, 0, 0, t->integerCount++);
+
+        case typeId:
+            if(t->nameCount == t->nameCapacity)
+                t->names = growArray(t->names, &t->nameCapacity, sizeof(linearName));
+            t->names[t->nameCount].name = p->id.id;
+            t->names[t->nameCount].symbol = p->id.symbol;
+            return addLinearNode(t, typeId, p->id.idType, 0, t->nameCount++);
+
+        case typeOperator:
+            break;
+
+        default:
+            assert(!"Linearising didn't match any rules");
+    }
+
+    /* the kept statements of a block are each preceded by a LINE, which
+       makes their line the current one */
+    nops = count = (uint32_t)p->opr.nops;
+    if(p->opr.oper == SEQUENCE)
+        for(i = 0; i < count; ++i)
+            if(p->opr.op[i] && p->opr.op[i]->type == typeOperator && p->opr.op[i]->opr.line)
+                ++nops;
+
+    /* the operands' indices go together; their slots are taken before
+       the operands are laid out, and filled in as they are */
+    first = (uint32_t)t->operandCount;
+    while((uint32_t)t->operandCapacity < first + nops)
+        t->operands = growArray(t->operands, &t->operandCapacity, sizeof(uint32_t));
+    t->operandCount += nops;
+
+    for(i = j = 0; i < count; ++i)
+    {
+        uint32_t operand;
+
+        if(nops != count && p->opr.op[i] &&
+           p->opr.op[i]->type == typeOperator && p->opr.op[i]->opr.line)
+        {
+            operand = addLinearNode(t, typeOperator, LINE, 0, p->opr.op[i]->opr.line);
+            t->operands[first + j++] = operand;
+        }
+        operand = lineariseNode(t, p->opr.op[i]);
+        t->operands[first + j++] = operand;
+    }
+
+    return addLinearNode(t, typeOperator, p->opr.oper, nops, first);
+}
+
+linearTree* linearise(nodeType* p)
+{
+    linearTree *t;
+
+    /* safely allocate space */
+    if((t = (linearTree*)calloc(1, sizeof(linearTree))) == NULL)
+        yyerror("Out of memory encountered.");
+
+    assert(t);
+    lineariseNode(t, p);
+    return t;
+}
+
+payload runLinearNode(linearTree* t, uint32_t index)
+{
+    linearNode *n = &t->nodes[index];
+    uint32_t *op;
+    payload result, op1, op2;
+
+    /* results are built in place, so only the fields that matter are set */
+    result.type = typeBool;
+    result.data.bool = -1;
+
+    switch(n->kind)
+    {
+        case typeBool:
+            return result;
+
+        case typeNumConstant:
+            result.type = typeNumConstant;
+            result.data.number = t->numbers[n->arg];
+            return result;
+
+        case typeVecConstant:
+            result.type = typeVecConstant;
+            result.data.vector = t->vectors[n->arg];
+            return result;
+
+        case typeVec2Constant:
+            result.type = typeVec2Constant;
+            result.data.vector2 = t->vectors2[n->arg];
+            return result;
+
+        case typeVec4Constant:
+            result.type = typeVec4Constant;
+            result.data.vector4 = t->vectors4[n->arg];
+            return result;
+
+        case typeIntConstant:
+            result.type = typeIntConstant;
+            result.data.integer = t->integers[n->arg];
+            return result;
+
+        case typeId:
+        {
+            symbolEntry *symbol = t->names[n->arg].symbol;
+
+            result.type = n->oper;
+            if(symbol)
+            {
+                if(n->oper == typeVecConstant)
+                    result.data.vector = symbol->data.vector;
+                else if(n->oper == typeIntConstant)
+                    result.data.integer = symbol->data.integer;
+                else if(IS_ARRAY(n->oper))
+                    result.data.array = &symbol->data.array;
+                else if(n->oper == typeVec2Constant)
+                    result.data.vector2 = symbol->data.vector2;
+                else if(n->oper == typeVec4Constant)
+                    result.data.vector4 = symbol->data.vector4;
+                else
+                    result.data.number = symbol->data.number;
+            }
+            return result;
+        }
+    }
+
+    op = t->operands + n->arg;
+
+    switch(n->oper)
+    {
+        case WHILE:
+        {
+            payload condition = runLinearNode(t, op[0]);
+
+            if(condition.type != typeBool)
+                yyerror("WHILE failed, the condition is not of type BOOL.");
+
+            /* the condition is re-evaluated before the body, as interpret()
+               does */
+            while(condition.data.bool && errorCount == statementErrors)
+            {
+                condition = runLinearNode(t, op[0]);
+                runLinearNode(t, op[1]);
+            }
+
+            result.data.bool = 0;
+            return result;
+        }
+
+        case IF:
+        {
+            payload condition = runLinearNode(t, op[0]);
+
+            if(condition.type != typeBool)
+                yyerror("IF failed, the condition is not of type BOOL.");
+
+            if(condition.data.bool)
+                runLinearNode(t, op[1]);
+            /* this can be an if-else */
+            else if(n->nops > 2)
+                runLinearNode(t, op[2]);
+
+            result.data.bool = 0;
+            return result;
+        }
+
+        case ';':
+        case SEQUENCE:
+        {
+            uint32_t i;
+
+            /* up to the first error */
+            for(i = 0; i + 1 < n->nops; ++i)
+            {
+                runLinearNode(t, op[i]);
+                if(errorCount != statementErrors)
+                    return result;
+            }
+            return runLinearNode(t, op[i]);
+        }
+
+        case LINE:
+            yylinenum = n->arg;
+            return result;
+
+        case '=':
+        {
+            /* an array, vec2 or vec4 assignment is left generic, and so
+               is one to an undeclared variable, which does nothing */
+            symbolEntry *symbol = t->names[t->nodes[op[0]].arg].symbol;
+
+            op2 = runLinearNode(t, op[1]);
+            result.data.bool = symbol != NULL;
+            if(symbol && symbol->type != op2.type)
+                yyerror("ERROR: Incompatible types to assign.");
+            else if(symbol && op2.type == typeVec2Constant)
+                symbol->data.vector2 = op2.data.vector2;
+            else if(symbol && op2.type == typeVec4Constant)
+                symbol->data.vector4 = op2.data.vector4;
+            else if(symbol)
+            {
+                assignArray(&symbol->data.array, op2.data.array);
+                return result;
+            }
+            if(IS_ARRAY(op2.type))
+                releaseArray(op2.data.array);
+            return result;
+        }
+
+        case PRINT:
+        {
+            /* only arrays, vec2 and vec4 are printed by the generic
+               operator */
+            linearNode *toPrint = &t->nodes[op[0]];
+
+            if(toPrint->kind == typeId)
+                fprintf(dataFile, "%s = ", t->names[toPrint->arg].name);
+
+            op1 = runLinearNode(t, op[0]);
+            if(IS_VECTOR_N(op1.type))
+            {
+                result.data.bool = printVectorN(dataFile, op1.type, &op1.data);
+                return result;
+            }
+            /* an error may have left no array behind */
+            if(!IS_ARRAY(op1.type))
+            {
+                yyerror("Wrong argument for printing.");
+                return result;
+            }
+            result.data.bool = printArray(dataFile, op1.data.array);
+            releaseArray(op1.data.array);
+            return result;
+        }
+
+        case VEC_ARRAY:
+        case NUM_ARRAY:
+            op1 = runLinearNode(t, op[0]);
+            return arrayPayload(newArray(n->oper == VEC_ARRAY ? typeVecArray : typeNumArray,
+                                         op1.data.integer));
+
+        case INDEX:
+        {
+            linearNode *array = &t->nodes[op[0]];
+
+            op2 = runLinearNode(t, op[1]);
+            result.type = elementType(array->oper);
+            getElement(&t->names[array->arg].symbol->data.array, op2.data.integer,
+                       &result.data);
+            return result;
+        }
+
+        case INDEX_ASSIGN:
+            op1 = runLinearNode(t, op[1]);
+            op2 = runLinearNode(t, op[2]);
+            result.data.bool = setElement(&t->names[t->nodes[op[0]].arg].symbol->data.array,
+                                          op1.data.integer, &op2.data);
+            return result;
+
+        case UMINUS:
+            /* only arrays, vec2 and vec4 are negated by the generic
+               operator */
+            op1 = runLinearNode(t, op[0]);
+            if(IS_VECTOR_N(op1.type))
+            {
+                result.type = vectorNOperator(UMINUS, op1.type, &op1.data,
+                                              op1.type, &op1.data, &result.data);
+                return result;
+            }
+            return arrayPayload(arrayOperator(UMINUS, op1.type, &op1.data,
+                                              op1.type, &op1.data));
+
+        case NUM_PRINT:
+        case VEC_PRINT:
+        case INT_PRINT:
+        {
+            linearNode *toPrint = &t->nodes[op[0]];
+
+            if(toPrint->kind == typeId)
+                fprintf(dataFile, "%s = ", t->names[toPrint->arg].name);
+
+            op1 = runLinearNode(t, op[0]);
+            /* a run-time error below stops the statement */
+            if(errorCount != statementErrors)
+                return result;
+            if(n->oper == VEC_PRINT)
+                result.data.bool = fprintf(dataFile, VECTOR_FORMAT "\n",
+                                           op1.data.vector.x,
+                                           op1.data.vector.y,
+                                           op1.data.vector.z);
+            else if(n->oper == INT_PRINT)
+                result.data.bool = fprintf(dataFile, INT64_FORMAT "\n", op1.data.integer);
+            else
+                result.data.bool = fprintf(dataFile, NUMBER_FORMAT "\n", op1.data.number);
+            return result;
+        }
+
+        case NUM_ASSIGN:
+            op2 = runLinearNode(t, op[1]);
+            if(errorCount != statementErrors)
+                return result;
+            t->names[t->nodes[op[0]].arg].symbol->data.number = op2.data.number;
+            result.data.bool = 1;
+            return result;
+
+        case VEC_ASSIGN:
+            op2 = runLinearNode(t, op[1]);
+            if(errorCount != statementErrors)
+                return result;
+            t->names[t->nodes[op[0]].arg].symbol->data.vector = op2.data.vector;
+            result.data.bool = 1;
+            return result;
+
+        case INT_ASSIGN:
+            op2 = runLinearNode(t, op[1]);
+            if(errorCount != statementErrors)
+                return result;
+            t->names[t->nodes[op[0]].arg].symbol->data.integer = op2.data.integer;
+            result.data.bool = 1;
+            return result;
+
+        case NUM_NEG:
+            result = runLinearNode(t, op[0]);
+            result.data.number = -result.data.number;
+            return result;
+
+        case INT_NEG:
+            result = runLinearNode(t, op[0]);
+            result.data.integer = INTEGER_NEG(result.data.integer);
+            return result;
+
+        case TO_NUMBER:
+            op1 = runLinearNode(t, op[0]);
+            result.type = typeNumConstant;
+            result.data.number = (real)op1.data.integer;
+            return result;
+
+        case VEC_NEG:
+            result = runLinearNode(t, op[0]);
+            vectorNeg(&result.data.vector, &result.data.vector);
+            return result;
+    }
+
+    /* the rest are binary operators */
+    op1 = runLinearNode(t, op[0]);
+    op2 = runLinearNode(t, op[1]);
+
+    switch(n->oper)
+    {
+        case NUM_ADD:
+            op1.data.number = op1.data.number + op2.data.number;
+            return op1;
+
+        case VEC_ADD:
+            vectorAdd(&op1.data.vector, &op2.data.vector, &op1.data.vector);
+            return op1;
+
+        case NUM_SUB:
+            op1.data.number = op1.data.number - op2.data.number;
+            return op1;
+
+        case VEC_SUB:
+            vectorSub(&op1.data.vector, &op2.data.vector, &op1.data.vector);
+            return op1;
+
+        case NUM_MUL:
+            op1.data.number = op1.data.number * op2.data.number;
+            return op1;
+
+        case VEC_SCALE:
+            vectorScale(&op1.data.vector, op2.data.number, &op1.data.vector);
+            return op1;
+
+        case SCALE_VEC:
+            vectorScale(&op2.data.vector, op1.data.number, &op2.data.vector);
+            return op2;
+
+        case NUM_DIV:
+            op1.data.number = op1.data.number / op2.data.number;
+            return op1;
+
+        case VEC_DIV:
+            vectorScale(&op1.data.vector, 1/op2.data.number, &op1.data.vector);
+            return op1;
+
+        case DIV_VEC:
+            /* the vector is divided, whichever side it is on */
+            vectorScale(&op2.data.vector, 1/op1.data.number, &op2.data.vector);
+            return op2;
+
+        case VEC_CROSS:
+            result.type = typeVecConstant;
+            vectorCross(&op1.data.vector, &op2.data.vector, &result.data.vector);
+            return result;
+
+        case VEC_DOT:
+            result.type = typeNumConstant;
+            result.data.number = vectorDot(&op1.data.vector, &op2.data.vector);
+            return result;
+
+        case NUM_LT: result.data.bool = op1.data.number < op2.data.number; return result;
+        case NUM_GT: result.data.bool = op1.data.number > op2.data.number; return result;
+        case NUM_GE: result.data.bool = op1.data.number >= op2.data.number; return result;
+        case NUM_LE: result.data.bool = op1.data.number <= op2.data.number; return result;
+
+        case NUM_EQ:
+            result.data.bool = numberCompare(op1.data.number, op2.data.number);
+            return result;
+
+        case NUM_NE:
+            result.data.bool = !numberCompare(op1.data.number, op2.data.number);
+            return result;
+
+        case VEC_EQ:
+            result.data.bool = vectorCompare(&op1.data.vector, &op2.data.vector);
+            return result;
+
+        case VEC_NE:
+            result.data.bool = !vectorCompare(&op1.data.vector, &op2.data.vector);
+            return result;
+
+        case INT_ADD:
+            op1.data.integer = INTEGER_ADD(op1.data.integer, op2.data.integer);
+            return op1;
+
+        case INT_SUB:
+            op1.data.integer = INTEGER_SUB(op1.data.integer, op2.data.integer);
+            return op1;
+
+        case INT_MUL:
+            op1.data.integer = INTEGER_MUL(op1.data.integer, op2.data.integer);
+            return op1;
+
+        case INT_DIV:
+            if(!integerDivide(op1.data.integer, op2.data.integer, &op1.data.integer))
+            {
+                yyerror("ERROR: integer division by zero.");
+                op1.type = -1;
+            }
+            return op1;
+
+        /* ints are compared exactly */
+        case INT_LT: result.data.bool = op1.data.integer < op2.data.integer; return result;
+        case INT_GT: result.data.bool = op1.data.integer > op2.data.integer; return result;
+        case INT_GE: result.data.bool = op1.data.integer >= op2.data.integer; return result;
+        case INT_LE: result.data.bool = op1.data.integer <= op2.data.integer; return result;
+        case INT_EQ: result.data.bool = op1.data.integer == op2.data.integer; return result;
+        case INT_NE: result.data.bool = op1.data.integer != op2.data.integer; return result;
+
+        /* the operators of whole arrays, vec2 and vec4 are left generic */
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case CROSS:
+        case DOT:
+        case EQ:
+        case NE:
+            if(IS_VECTOR_N(op1.type) || IS_VECTOR_N(op2.type))
+            {
+                result.type = vectorNOperator(n->oper, op1.type, &op1.data,
+                                              op2.type, &op2.data, &result.data);
+                return result;
+            }
+            if(n->oper == EQ || n->oper == NE)
+            {
+                result.data.bool = compareArrays(op1.data.array, op2.data.array) ==
+                                   (n->oper == EQ);
+                return result;
+            }
+            return arrayPayload(arrayOperator(n->oper, op1.type, &op1.data,
+                                              op2.type, &op2.data));
+    }
+
+    assert(!"Walking the linear tree didn't match any rules");
+    return result;
+}
+
+void runLinear(linearTree* t)
+{
+    /* the root is laid out last */
+    if(t->nodeCount > 0)
+        runLinearNode(t, t->nodeCount - 1);
+}
+
+void freeLinear(linearTree* t)
+{
+    /* check if the tree is free already; if yes - return */
+    if(!t) return;
+
+    free(t->nodes);
+    free(t->operands);
+    free(t->numbers);
+    free(t->vectors);
+    free(t->vectors2);
+    free(t->vectors4);
+    free(t->integers);
+    free(t->names);
+    free(t);
+}
@@ -0,0 +1,60 @@
+#ifndef LINEAR_TREE_H
+#define LINEAR_TREE_H
+/*
+ * The linear form of the parse tree: the nodes of a statement are laid
+ * out in one contiguous buffer, in post-order (operands before the
+ * operator, the root last), and refer to each other by 32-bit indices
+ * instead of pointers. Constants and variables are kept in tables of
+ * their own, so every node has the same small size.
+ *
+ */
+
+#include <stdint.h>
+#include "ParseTree.h"
+
+/* a node of the linear tree */
+typedef struct {
+    int kind;                   /* nodeEnum of the node; typeBool for an
+                                   empty statement */
+    int oper;                   /* operator, or the type of a variable */
+    uint32_t nops;              /* number of operands */
+    uint32_t arg;               /* index into the constants or names for
+                                   a leaf, of the first operand index for
+                                   an operator; the line for a LINE */
+} linearNode;
+
+/* a variable referenced by the tree */
+typedef struct {
+    char* name;                 /* id string, for printing */
+    struct symbolNode* symbol;  /* its symbol table entry, or NULL */
+} linearName;
+
+/* a linearised statement */
+typedef struct {
+    linearNode* nodes;          /* the nodes, in post-order */
+    int nodeCount, nodeCapacity;
+    uint32_t* operands;         /* operand indices of the operators */
+    int operandCount, operandCapacity;
+    real* numbers;              /* numeric constants */
+    int numberCount, numberCapacity;
+    vector3* vectors;           /* vector constants */
+    int vectorCount, vectorCapacity;
+    vec2* vectors2;             /* vec2 constants */
+    int vector2Count, vector2Capacity;
+    vec4* vectors4;             /* vec4 constants */
+    int vector4Count, vector4Capacity;
+    int64* integers;            /* int constants */
+    int integerCount, integerCapacity;
+    linearName* names;          /* variables */
+    int nameCount, nameCapacity;
+} linearTree;
+
+/* Lays out a type-checked and specialised statement in a linear tree. */
+linearTree* linearise(nodeType*);
+
+/* Runs the statement, walking the buffer as interpret() walks the tree. */
+void runLinear(linearTree*);
+
+void freeLinear(linearTree*);
+
+#endif
@@ -5,23 +5,122 @@
 #include <assert.h>
 #include "Defines.h"
 #include "Math.h"
+#include "ParseTree.h"
 
-int numberCompare(double n1, double n2)
+/* the vector instructions the array kernels are built with, over doubles
+   or - in the single precision build - over twice as many floats */
+#if !defined(NO_SIMD) && defined(__AVX2__) && defined(SINGLE_PRECISION)
+    #include <immintrin.h>
+    #define SIMD_WIDTH 8
+    #define SIMD_ALL_LANES 0xFF
+    typedef __m256 simdReal;
+    #define simdLoad(p)         _mm256_loadu_ps(p)
+    #define simdStore(p, v)     _mm256_storeu_ps(p, v)
+    #define simdSet(s)          _mm256_set1_ps(s)
+    #define simdAdd(a, b)       _mm256_add_ps(a, b)
+    #define simdSub(a, b)       _mm256_sub_ps(a, b)
+    #define simdMul(a, b)       _mm256_mul_ps(a, b)
+    #define simdDiv(a, b)       _mm256_div_ps(a, b)
+    /* flips the sign bit, so zero becomes -0 as with the unary minus */
+    #define simdNeg(a)          _mm256_xor_ps(a, _mm256_set1_ps(-0.0f))
+    #define simdLessMask(a, b)  _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ))
+#elif !defined(NO_SIMD) && defined(__AVX2__)
+    #include <immintrin.h>
+    #define SIMD_WIDTH 4
+    #define SIMD_ALL_LANES 0xF
+    typedef __m256d simdReal;
+    #define simdLoad(p)         _mm256_loadu_pd(p)
+    #define simdStore(p, v)     _mm256_storeu_pd(p, v)
+    #define simdSet(s)          _mm256_set1_pd(s)
+    #define simdAdd(a, b)       _mm256_add_pd(a, b)
+    #define simdSub(a, b)       _mm256_sub_pd(a, b)
+    #define simdMul(a, b)       _mm256_mul_pd(a, b)
+    #define simdDiv(a, b)       _mm256_div_pd(a, b)
+    #define simdNeg(a)          _mm256_xor_pd(a, _mm256_set1_pd(-0.0))
+    #define simdLessMask(a, b)  _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LT_OQ))
+#elif !defined(NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || \
+                            (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #ifdef SINGLE_PRECISION
+        #define SIMD_WIDTH 4
+        #define SIMD_ALL_LANES 0xF
+        typedef __m128 simdReal;
+        #define simdLoad(p)         _mm_loadu_ps(p)
+        #define simdStore(p, v)     _mm_storeu_ps(p, v)
+        #define simdSet(s)          _mm_set1_ps(s)
+        #define simdAdd(a, b)       _mm_add_ps(a, b)
+        #define simdSub(a, b)       _mm_sub_ps(a, b)
+        #define simdMul(a, b)       _mm_mul_ps(a, b)
+        #define simdDiv(a, b)       _mm_div_ps(a, b)
+        #define simdNeg(a)          _mm_xor_ps(a, _mm_set1_ps(-0.0f))
+        #define simdLessMask(a, b)  _mm_movemask_ps(_mm_cmplt_ps(a, b))
+    #else
+        #define SIMD_WIDTH 2
+        #define SIMD_ALL_LANES 0x3
+        typedef __m128d simdReal;
+        #define simdLoad(p)         _mm_loadu_pd(p)
+        #define simdStore(p, v)     _mm_storeu_pd(p, v)
+        #define simdSet(s)          _mm_set1_pd(s)
+        #define simdAdd(a, b)       _mm_add_pd(a, b)
+        #define simdSub(a, b)       _mm_sub_pd(a, b)
+        #define simdMul(a, b)       _mm_mul_pd(a, b)
+        #define simdDiv(a, b)       _mm_div_pd(a, b)
+        #define simdNeg(a)          _mm_xor_pd(a, _mm_set1_pd(-0.0))
+        #define simdLessMask(a, b)  _mm_movemask_pd(_mm_cmplt_pd(a, b))
+    #endif
+#endif
+
+/* a padded vector (see Defines.h) is operated on as SSE registers: one
+   holding all four floats, or two holding two doubles each */
+#if defined(PADDED_VECTORS) && defined(SIMD_WIDTH)
+    #ifdef SINGLE_PRECISION
+        #define PACKED_VECTORS 1
+    #else
+        #define PACKED_VECTORS 2
+    #endif
+#endif
+
+/* functions prototypes */
+void columnAdd(real*, real*, real*, int);
+void columnSub(real*, real*, real*, int);
+void columnAddScalar(real*, real, real*, int);
+void columnSubScalar(real*, real, real*, int);
+void scalarSubColumn(real, real*, real*, int);
+void columnScale(real*, real, real*, int);
+void columnMul(real*, real*, real*, int);
+void columnDiv(real*, real*, real*, int);
+void columnDivScalar(real*, real, real*, int);
+void scalarDivColumn(real, real*, real*, int);
+void columnMulReciprocal(real*, real*, real*, int);
+void columnNeg(real*, real*, int);
+int columnCompare(real*, real*, int);
+
+int numberCompare(real n1, real n2)
 {
-    double delta = 999999;
+    real delta = 999999;
 
     delta = n2 - n1;
     return delta < EPSILON;
 }
 
-int vectorCompare(vector3* v1, vector3* v2)
+
+int integerDivide(int64 dividend, int64 divisor, int64* quotient)
 {
-    return numberCompare(v1->x, v2->x) &&
-           numberCompare(v1->y, v2->y) &&
-           numberCompare(v1->z, v2->z);
+    if(divisor == 0)
+    {
+        *quotient = 0;
+        return 0;
+    }
+
+    /* the smallest int divided by -1 overflows, and traps on x86 */
+    if(divisor == -1)
+        *quotient = INTEGER_NEG(dividend);
+    else
+        *quotient = dividend / divisor;
+    return 1;
 }
 
-vector3* newVector(double x, double y, double z)
+vector3* newVector(real x, real y, real z)
 {
     vector3 *vector = NULL;
 
@@ -33,93 +132,622 @@ vector3* newVector(double x, double y, double z)
     vector->x = x;
     vector->y = y;
     vector->z = z;
+#ifdef PADDED_VECTORS
+    vector->w = 0;
+#endif
     
     assert(vector);
 
     return vector;
 }
 
+/* The kernels of the vectors of every dimension are generated from the
+   one template below, given the components after x: each is written out
+   component by component, with no loop and no branch. */
+#define VEC2_AFTER_X(each)  each(y)
+#define VEC3_AFTER_X(each)  each(y) each(z)
+#define VEC4_AFTER_X(each)  each(y) each(z) each(w)
+
+#define ADD_COMPONENT(c)    result->c = v1->c + v2->c;
+#define SUB_COMPONENT(c)    result->c = v1->c - v2->c;
+#define SCALE_COMPONENT(c)  result->c = v->c * s;
+#define NEG_COMPONENT(c)    result->c = -v->c;
+#define DOT_TERM(c)         + v1->c * v2->c
+/* the comparisons are joined with &, not &&, so none of them is skipped */
+#define COMPARE_TERM(c)     & numberCompare(v1->c, v2->c)
+
+#define VECTOR_ARITHMETIC(type, name, AFTER_X)                          \
+    void name##Add(type* v1, type* v2, type* result)                    \
+    {                                                                   \
+        assert(result);                                                 \
+        ADD_COMPONENT(x) AFTER_X(ADD_COMPONENT)                         \
+    }                                                                   \
+                                                                        \
+    void name##Sub(type* v1, type* v2, type* result)                    \
+    {                                                                   \
+        assert(result);                                                 \
+        SUB_COMPONENT(x) AFTER_X(SUB_COMPONENT)                         \
+    }                                                                   \
+                                                                        \
+    void name##Scale(type* v, real s, type* result)                     \
+    {                                                                   \
+        assert(result);                                                 \
+        SCALE_COMPONENT(x) AFTER_X(SCALE_COMPONENT)                     \
+    }                                                                   \
+                                                                        \
+    void name##Neg(type* v, type* result)                               \
+    {                                                                   \
+        assert(result);                                                 \
+        NEG_COMPONENT(x) AFTER_X(NEG_COMPONENT)                         \
+    }                                                                   \
+                                                                        \
+    real name##Dot(type* v1, type* v2)                                  \
+    {                                                                   \
+        return v1->x * v2->x AFTER_X(DOT_TERM);                         \
+    }
+
+#define VECTOR_COMPARE(type, name, AFTER_X)                             \
+    int name##Compare(type* v1, type* v2)                               \
+    {                                                                   \
+        return numberCompare(v1->x, v2->x) AFTER_X(COMPARE_TERM);       \
+    }
+
+VECTOR_ARITHMETIC(vec2, vec2, VEC2_AFTER_X)
+VECTOR_ARITHMETIC(vec4, vec4, VEC4_AFTER_X)
+
+VECTOR_COMPARE(vec2, vec2, VEC2_AFTER_X)
+VECTOR_COMPARE(vector3, vector, VEC3_AFTER_X)
+VECTOR_COMPARE(vec4, vec4, VEC4_AFTER_X)
+
+/* a padded vector3 is operated on as SSE registers instead */
+#ifndef PACKED_VECTORS
+VECTOR_ARITHMETIC(vector3, vector, VEC3_AFTER_X)
+#else
 void vectorAdd(vector3* v1, vector3* v2, vector3* result)
 {
     assert(result);
-    result->x = v1->x + v2->x;
-    result->y = v1->y + v2->y;
-    result->z = v1->z + v2->z;
+#if PACKED_VECTORS == 1
+    _mm_store_ps(&result->x, _mm_add_ps(_mm_load_ps(&v1->x), _mm_load_ps(&v2->x)));
+#else
+    _mm_store_pd(&result->x, _mm_add_pd(_mm_load_pd(&v1->x), _mm_load_pd(&v2->x)));
+    _mm_store_pd(&result->z, _mm_add_pd(_mm_load_pd(&v1->z), _mm_load_pd(&v2->z)));
+#endif
 }
 
-vector3* vectorAdd_new(vector3* v1, vector3* v2)
+void vectorSub(vector3* v1, vector3* v2, vector3* result)
 {
-    vector3* result = newVector(0,0,0);
     assert(result);
-    result->x = v1->x + v2->x;
-    result->y = v1->y + v2->y;
-    result->z = v1->z + v2->z;
+#if PACKED_VECTORS == 1
+    _mm_store_ps(&result->x, _mm_sub_ps(_mm_load_ps(&v1->x), _mm_load_ps(&v2->x)));
+#else
+    _mm_store_pd(&result->x, _mm_sub_pd(_mm_load_pd(&v1->x), _mm_load_pd(&v2->x)));
+    _mm_store_pd(&result->z, _mm_sub_pd(_mm_load_pd(&v1->z), _mm_load_pd(&v2->z)));
+#endif
+}
 
-    return result;
+void vectorScale(vector3* v, real s, vector3* result)
+{
+#if PACKED_VECTORS == 1
+    assert(result);
+    _mm_store_ps(&result->x, _mm_mul_ps(_mm_load_ps(&v->x), _mm_set1_ps(s)));
+#else
+    __m128d scale = _mm_set1_pd(s);
+
+    assert(result);
+    _mm_store_pd(&result->x, _mm_mul_pd(_mm_load_pd(&v->x), scale));
+    _mm_store_pd(&result->z, _mm_mul_pd(_mm_load_pd(&v->z), scale));
+#endif
 }
 
-void vectorSub(vector3* v1, vector3* v2, vector3* result)
+void vectorNeg(vector3* v, vector3* result)
 {
+#if PACKED_VECTORS == 1
+    /* flips the sign bits, so zero becomes -0 as with the unary minus */
+    assert(result);
+    _mm_store_ps(&result->x, _mm_xor_ps(_mm_load_ps(&v->x), _mm_set1_ps(-0.0f)));
+#else
+    /* flips the sign bits, so zero becomes -0 as with the unary minus */
+    __m128d sign = _mm_set1_pd(-0.0);
+
     assert(result);
-    result->x = v1->x - v2->x;
-    result->y = v1->y - v2->y;
-    result->z = v1->z - v2->z;
+    _mm_store_pd(&result->x, _mm_xor_pd(_mm_load_pd(&v->x), sign));
+    _mm_store_pd(&result->z, _mm_xor_pd(_mm_load_pd(&v->z), sign));
+#endif
 }
 
-vector3* vectorSub_new(vector3* v1, vector3* v2)
+real vectorDot(vector3* v1, vector3* v2)
+{
+#if PACKED_VECTORS == 1
+    __m128 products = _mm_mul_ps(_mm_load_ps(&v1->x), _mm_load_ps(&v2->x));
+
+    /* summed in the same order as the template: (x + y) + z */
+    return _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(products, _mm_shuffle_ps(products, products, 1)),
+                                    _mm_movehl_ps(products, products)));
+#else
+    __m128d xy = _mm_mul_pd(_mm_load_pd(&v1->x), _mm_load_pd(&v2->x));
+    __m128d z = _mm_mul_sd(_mm_load_sd(&v1->z), _mm_load_sd(&v2->z));
+
+    /* summed in the same order as the template: (x + y) + z */
+    return _mm_cvtsd_f64(_mm_add_sd(_mm_add_sd(xy, _mm_unpackhi_pd(xy, xy)), z));
+#endif
+}
+#endif
+
+void vectorCross(vector3* v1, vector3* v2, vector3* result)
 {
-    vector3* result = newVector(0,0,0);
+#if PACKED_VECTORS == 1
+    __m128 a = _mm_load_ps(&v1->x), b = _mm_load_ps(&v2->x);
+    /* {y1, z1, x1} * {z2, x2, y2} - {z1, x1, y1} * {y2, z2, x2} */
+    __m128 xyz = _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)),
+                                       _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2))),
+                            _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2)),
+                                       _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1))));
+
     assert(result);
-    result->x = v1->x - v2->x;
-    result->y = v1->y - v2->y;
-    result->z = v1->z - v2->z;
+    _mm_store_ps(&result->x, xyz);
+#elif PACKED_VECTORS == 2
+    __m128d axy = _mm_load_pd(&v1->x), azw = _mm_load_pd(&v1->z);
+    __m128d bxy = _mm_load_pd(&v2->x), bzw = _mm_load_pd(&v2->z);
+    /* {y1 z2 - z1 y2, z1 x2 - x1 z2}, then x1 y2 - y1 x2 in the low lane;
+       everything is loaded first, as the result may be an operand */
+    __m128d xy = _mm_sub_pd(_mm_mul_pd(_mm_shuffle_pd(axy, azw, 1), _mm_shuffle_pd(bzw, bxy, 0)),
+                            _mm_mul_pd(_mm_shuffle_pd(azw, axy, 0), _mm_shuffle_pd(bxy, bzw, 1)));
+    __m128d zw = _mm_sub_sd(_mm_mul_sd(axy, _mm_unpackhi_pd(bxy, bxy)),
+                            _mm_mul_sd(_mm_unpackhi_pd(axy, axy), bxy));
 
-    return result;
+    assert(result);
+    _mm_store_pd(&result->x, xy);
+    _mm_store_pd(&result->z, zw);
+#else
+    assert(result);
+    result->x = v1->y * v2->z - v1->z * v2->y;
+    result->y = v1->z * v2->x - v1->x * v2->z;
+    result->z = v1->x * v2->y - v1->y * v2->x;
+#endif
 }
 
-vector3* vectorScale_new(vector3* v, double s)
+/* the arrays are processed a column at a time, so every loop runs down
+   contiguous memory - and a few elements at once, with the widest vector
+   instructions the compiler targets: AVX2 takes 4 doubles or 8 floats,
+   SSE2 takes 2 doubles or 4 floats. The elements left over at the end of
+   a column go one at a time, through the same operations in the same
+   order, so every element comes out exactly as the scalar routines would
+   give it. Defining NO_SIMD keeps all of the kernels scalar. */
+void columnAdd(real* a, real* b, real* result, int length)
 {
-    return newVector(v->x * s, v->y * s, v->z *s);
+    int i = 0;
+#ifdef SIMD_WIDTH
+    for(; i + SIMD_WIDTH <= length; i += SIMD_WIDTH)
+        simdStore(result + i, simdAdd(simdLoad(a + i), simdLoad(b + i)));
+#endif
+    for(; i < length; ++i)
+        result[i] = a[i] + b[i];
 }
 
-void vectorNeg(vector3* v, vector3* result)
+void columnSub(real* a, real* b, real* result, int length)
+{
+    int i = 0;
+#ifdef SIMD_WIDTH
+    for(; i + SIMD_WIDTH <= length; i += SIMD_WIDTH)
+        simdStore(result + i, simdSub(simdLoad(a + i), simdLoad(b + i)));
+#endif
+    for(; i < length; ++i)
+        result[i] = a[i] - b[i];
+}
+
+void columnAddScalar(real* a, real s, real* result, int length)
+{
+    int i = 0;
+#ifdef SIMD_WIDTH
+    simdReal scalar = simdSet(s);
+    for(; i + SIMD_WIDTH <= length; i += SIMD_WIDTH)
+        simdStore(result + i, simdAdd(simdLoad(a + i), scalar));
+#endif
+    for(; i < length; ++i)
+        result[i] = a[i] + s;
+}
+
+void columnSubScalar(real* a, real s, real* result, int length)
+{
+    int i = 0;
+#ifdef SIMD_WIDTH
+    simdReal scalar = simdSet(s);
+    for(; i + SIMD_WIDTH <= length; i += SIMD_WIDTH)
+        simdStore(result + i, simdSub(simdLoad(a + i), scalar));
+#endif
+    for(; i < length; ++i)
+        result[i] = a[i] - s;
+}
+
+void scalarSubColumn(real s, real* a, real* result, int length)
+{
+    int i = 0;
+#ifdef SIMD_WIDTH
+    simdReal scalar = simdSet(s);
+    for(; i + SIMD_WIDTH <= length; i += SIMD_WIDTH)
+        simdStore(result + i, simdSub(scalar, simdLoad(a + i)));
+#endif
+    for(; i < length; ++i)
+        result[i] = s - a[i];
+}
+
+void columnScale(real* a, real s, real* result, int length)
+{
+    int i = 0;
+#ifdef SIMD_WIDTH
+    simdReal scalar = simdSet(s);
+    for(; i + SIMD_WIDTH <= length; i += SIMD_WIDTH)
+        simdStore(result + i, simdMul(simdLoad(a + i), scalar));
+#endif
+    for(; i < length; ++i)
+        result[i] = a[i] * s;
+}
+
+void columnMul(real* a, real* b, real* result, int length)
+{
+    int i = 0;
+#ifdef SIMD_WIDTH
+    for(; i + SIMD_WIDTH <= length; i += SIMD_WIDTH)
+        simdStore(result + i, simdMul(simdLoad(a + i), simdLoad(b + i)));
+#endif
+    for(; i < length; ++i)
+        result[i] = a[i] * b[i];
+}
+
+void columnDiv(real* a, real* b, real* result, int length)
+{
+    int i = 0;
+#ifdef SIMD_WIDTH
+    for(; i + SIMD_WIDTH <= length; i += SIMD_WIDTH)
+        simdStore(result + i, simdDiv(simdLoad(a + i), simdLoad(b + i)));
+#endif
+    for(; i < length; ++i)
+        result[i] = a[i] / b[i];
+}
+
+void columnDivScalar(real* a, real s, real* result, int length)
+{
+    int i = 0;
+#ifdef SIMD_WIDTH
+    simdReal scalar = simdSet(s);
+    for(; i + SIMD_WIDTH <= length; i += SIMD_WIDTH)
+        simdStore(result + i, simdDiv(simdLoad(a + i), scalar));
+#endif
+    for(; i < length; ++i)
+        result[i] = a[i] / s;
+}
+
+void scalarDivColumn(real s, real* a, real* result, int length)
+{
+    int i = 0;
+#ifdef SIMD_WIDTH
+    simdReal scalar = simdSet(s);
+    for(; i + SIMD_WIDTH <= length; i += SIMD_WIDTH)
+        simdStore(result + i, simdDiv(scalar, simdLoad(a + i)));
+#endif
+    for(; i < length; ++i)
+        result[i] = s / a[i];
+}
+
+/* a vector component divided by a number is scaled by its reciprocal */
+void columnMulReciprocal(real* a, real* b, real* result, int length)
+{
+    int i = 0;
+#ifdef SIMD_WIDTH
+    simdReal one = simdSet(1);
+    for(; i + SIMD_WIDTH <= length; i += SIMD_WIDTH)
+        simdStore(result + i, simdMul(simdLoad(a + i), simdDiv(one, simdLoad(b + i))));
+#endif
+    for(; i < length; ++i)
+        result[i] = a[i] * (1 / b[i]);
+}
+
+void columnNeg(real* a, real* result, int length)
+{
+    int i = 0;
+#ifdef SIMD_WIDTH
+    for(; i + SIMD_WIDTH <= length; i += SIMD_WIDTH)
+        simdStore(result + i, simdNeg(simdLoad(a + i)));
+#endif
+    for(; i < length; ++i)
+        result[i] = -a[i];
+}
+
+int columnCompare(real* a, real* b, int length)
+{
+    int i = 0;
+#ifdef SIMD_WIDTH
+    /* the same test as numberCompare(), on every lane */
+    simdReal epsilon = simdSet(EPSILON);
+    for(; i + SIMD_WIDTH <= length; i += SIMD_WIDTH)
+        if(simdLessMask(simdSub(simdLoad(b + i), simdLoad(a + i)), epsilon) != SIMD_ALL_LANES)
+            return 0;
+#endif
+    for(; i < length; ++i)
+        if(!numberCompare(a[i], b[i]))
+            return 0;
+    return 1;
+}
+
+void arrayAdd(vectorArray* a1, vectorArray* a2, vectorArray* result)
+{
+    assert(result && a1->length == a2->length);
+    columnAdd(a1->x, a2->x, result->x, a1->length);
+    if(a1->type == typeVecArray)
+    {
+        columnAdd(a1->y, a2->y, result->y, a1->length);
+        columnAdd(a1->z, a2->z, result->z, a1->length);
+    }
+}
+
+void arraySub(vectorArray* a1, vectorArray* a2, vectorArray* result)
+{
+    assert(result && a1->length == a2->length);
+    columnSub(a1->x, a2->x, result->x, a1->length);
+    if(a1->type == typeVecArray)
+    {
+        columnSub(a1->y, a2->y, result->y, a1->length);
+        columnSub(a1->z, a2->z, result->z, a1->length);
+    }
+}
+
+void arrayScale(vectorArray* a, real s, vectorArray* result)
+{
+    assert(result);
+    columnScale(a->x, s, result->x, a->length);
+    if(a->type == typeVecArray)
+    {
+        columnScale(a->y, s, result->y, a->length);
+        columnScale(a->z, s, result->z, a->length);
+    }
+}
+
+void arrayNeg(vectorArray* a, vectorArray* result)
 {
     assert(result);
-    result->x = -v->x;
-    result->y = -v->y;
-    result->z = -v->z;
+    columnNeg(a->x, result->x, a->length);
+    if(a->type == typeVecArray)
+    {
+        columnNeg(a->y, result->y, a->length);
+        columnNeg(a->z, result->z, a->length);
+    }
 }
 
-vector3* vectorNeg_new(vector3* v)
+void arrayAddVector(vectorArray* a, vector3* v, vectorArray* result)
 {
-    vector3* result = newVector(0,0,0);
     assert(result);
-    result->x = -v->x;
-    result->y = -v->y;
-    result->z = -v->z;
+    columnAddScalar(a->x, v->x, result->x, a->length);
+    columnAddScalar(a->y, v->y, result->y, a->length);
+    columnAddScalar(a->z, v->z, result->z, a->length);
+}
 
-    return result;
+void arraySubVector(vectorArray* a, vector3* v, vectorArray* result)
+{
+    assert(result);
+    columnSubScalar(a->x, v->x, result->x, a->length);
+    columnSubScalar(a->y, v->y, result->y, a->length);
+    columnSubScalar(a->z, v->z, result->z, a->length);
 }
 
-double vectorDot(vector3* v1, vector3* v2)
+void vectorSubArray(vector3* v, vectorArray* a, vectorArray* result)
 {
-    return v1->x * v2->x + 
-           v1->y * v2->y +
-           v1->z * v2->z;
+    assert(result);
+    scalarSubColumn(v->x, a->x, result->x, a->length);
+    scalarSubColumn(v->y, a->y, result->y, a->length);
+    scalarSubColumn(v->z, a->z, result->z, a->length);
 }
 
-void vectorCross(vector3* v1, vector3* v2, vector3* result)
+void arrayAddNumber(vectorArray* a, real s, vectorArray* result)
 {
     assert(result);
-    result->x = v1->y * v2->z - v1->z * v2->y;
-    result->y = v1->z * v2->x - v1->x * v2->z;
-    result->z = v1->x * v2->y - v1->y * v2->x;
+    columnAddScalar(a->x, s, result->x, a->length);
+}
+
+void arraySubNumber(vectorArray* a, real s, vectorArray* result)
+{
+    assert(result);
+    columnSubScalar(a->x, s, result->x, a->length);
+}
+
+void numberSubArray(real s, vectorArray* a, vectorArray* result)
+{
+    assert(result);
+    scalarSubColumn(s, a->x, result->x, a->length);
+}
+
+void arrayDivNumber(vectorArray* a, real s, vectorArray* result)
+{
+    assert(result);
+    columnDivScalar(a->x, s, result->x, a->length);
+}
+
+void numberDivArray(real s, vectorArray* a, vectorArray* result)
+{
+    assert(result);
+    scalarDivColumn(s, a->x, result->x, a->length);
+}
+
+void arrayMulArray(vectorArray* a, vectorArray* numbers, vectorArray* result)
+{
+    assert(result && a->length == numbers->length);
+    columnMul(a->x, numbers->x, result->x, a->length);
+    if(a->type == typeVecArray)
+    {
+        columnMul(a->y, numbers->x, result->y, a->length);
+        columnMul(a->z, numbers->x, result->z, a->length);
+    }
+}
+
+void arrayDivArray(vectorArray* a, vectorArray* numbers, vectorArray* result)
+{
+    assert(result && a->length == numbers->length);
+    if(a->type != typeVecArray)
+    {
+        columnDiv(a->x, numbers->x, result->x, a->length);
+        return;
+    }
+    columnMulReciprocal(a->x, numbers->x, result->x, a->length);
+    columnMulReciprocal(a->y, numbers->x, result->y, a->length);
+    columnMulReciprocal(a->z, numbers->x, result->z, a->length);
+}
+
+void vectorMulArray(vector3* v, vectorArray* numbers, vectorArray* result)
+{
+    assert(result);
+    columnScale(numbers->x, v->x, result->x, numbers->length);
+    columnScale(numbers->x, v->y, result->y, numbers->length);
+    columnScale(numbers->x, v->z, result->z, numbers->length);
 }
 
-vector3* vectorCross_new(vector3* v1, vector3* v2)
+void vectorDivArray(vector3* v, vectorArray* numbers, vectorArray* result)
 {
-    return newVector(v1->y * v2->z - v1->z * v2->y,
-                     v1->z * v2->x - v1->x * v2->z,
-                     v1->x * v2->y - v1->y * v2->x);
+    assert(result);
+    /* the reciprocals go into the x column first, which is scaled last */
+    scalarDivColumn(1, numbers->x, result->x, numbers->length);
+    columnScale(result->x, v->y, result->y, numbers->length);
+    columnScale(result->x, v->z, result->z, numbers->length);
+    columnScale(result->x, v->x, result->x, numbers->length);
+}
+
+void arrayDot(vectorArray* a1, vectorArray* a2, vectorArray* result)
+{
+    int i = 0;
+
+    assert(result && a1->length == a2->length);
+#ifdef SIMD_WIDTH
+    for(; i + SIMD_WIDTH <= a1->length; i += SIMD_WIDTH)
+        simdStore(result->x + i,
+                  simdAdd(simdAdd(simdMul(simdLoad(a1->x + i), simdLoad(a2->x + i)),
+                                  simdMul(simdLoad(a1->y + i), simdLoad(a2->y + i))),
+                          simdMul(simdLoad(a1->z + i), simdLoad(a2->z + i))));
+#endif
+    for(; i < a1->length; ++i)
+        result->x[i] = a1->x[i] * a2->x[i] +
+                       a1->y[i] * a2->y[i] +
+                       a1->z[i] * a2->z[i];
 }
 
+void arrayDotVector(vectorArray* a, vector3* v, vectorArray* result)
+{
+    int i = 0;
+#ifdef SIMD_WIDTH
+    simdReal vx = simdSet(v->x), vy = simdSet(v->y), vz = simdSet(v->z);
+#endif
+
+    assert(result);
+#ifdef SIMD_WIDTH
+    for(; i + SIMD_WIDTH <= a->length; i += SIMD_WIDTH)
+        simdStore(result->x + i,
+                  simdAdd(simdAdd(simdMul(simdLoad(a->x + i), vx),
+                                  simdMul(simdLoad(a->y + i), vy)),
+                          simdMul(simdLoad(a->z + i), vz)));
+#endif
+    for(; i < a->length; ++i)
+        result->x[i] = a->x[i] * v->x +
+                       a->y[i] * v->y +
+                       a->z[i] * v->z;
+}
+
+void arrayCross(vectorArray* a1, vectorArray* a2, vectorArray* result)
+{
+    real x, y, z;
+    int i = 0;
+#ifdef SIMD_WIDTH
+    simdReal ax, ay, az, bx, by, bz;
+#endif
+
+    assert(result && a1->length == a2->length);
+#ifdef SIMD_WIDTH
+    for(; i + SIMD_WIDTH <= a1->length; i += SIMD_WIDTH)
+    {
+        /* everything is loaded before the result is stored, as it may be
+           one of the operands */
+        ax = simdLoad(a1->x + i); ay = simdLoad(a1->y + i); az = simdLoad(a1->z + i);
+        bx = simdLoad(a2->x + i); by = simdLoad(a2->y + i); bz = simdLoad(a2->z + i);
+        simdStore(result->x + i, simdSub(simdMul(ay, bz), simdMul(az, by)));
+        simdStore(result->y + i, simdSub(simdMul(az, bx), simdMul(ax, bz)));
+        simdStore(result->z + i, simdSub(simdMul(ax, by), simdMul(ay, bx)));
+    }
+#endif
+    for(; i < a1->length; ++i)
+    {
+        /* the result may be one of the operands */
+        x = a1->y[i] * a2->z[i] - a1->z[i] * a2->y[i];
+        y = a1->z[i] * a2->x[i] - a1->x[i] * a2->z[i];
+        z = a1->x[i] * a2->y[i] - a1->y[i] * a2->x[i];
+        result->x[i] = x;
+        result->y[i] = y;
+        result->z[i] = z;
+    }
+}
+
+void arrayCrossVector(vectorArray* a, vector3* v, vectorArray* result)
+{
+    real x, y, z;
+    int i = 0;
+#ifdef SIMD_WIDTH
+    simdReal ax, ay, az;
+    simdReal vx = simdSet(v->x), vy = simdSet(v->y), vz = simdSet(v->z);
+#endif
+
+    assert(result);
+#ifdef SIMD_WIDTH
+    for(; i + SIMD_WIDTH <= a->length; i += SIMD_WIDTH)
+    {
+        ax = simdLoad(a->x + i); ay = simdLoad(a->y + i); az = simdLoad(a->z + i);
+        simdStore(result->x + i, simdSub(simdMul(ay, vz), simdMul(az, vy)));
+        simdStore(result->y + i, simdSub(simdMul(az, vx), simdMul(ax, vz)));
+        simdStore(result->z + i, simdSub(simdMul(ax, vy), simdMul(ay, vx)));
+    }
+#endif
+    for(; i < a->length; ++i)
+    {
+        x = a->y[i] * v->z - a->z[i] * v->y;
+        y = a->z[i] * v->x - a->x[i] * v->z;
+        z = a->x[i] * v->y - a->y[i] * v->x;
+        result->x[i] = x;
+        result->y[i] = y;
+        result->z[i] = z;
+    }
+}
+
+void vectorCrossArray(vector3* v, vectorArray* a, vectorArray* result)
+{
+    real x, y, z;
+    int i = 0;
+#ifdef SIMD_WIDTH
+    simdReal ax, ay, az;
+    simdReal vx = simdSet(v->x), vy = simdSet(v->y), vz = simdSet(v->z);
+#endif
+
+    assert(result);
+#ifdef SIMD_WIDTH
+    for(; i + SIMD_WIDTH <= a->length; i += SIMD_WIDTH)
+    {
+        ax = simdLoad(a->x + i); ay = simdLoad(a->y + i); az = simdLoad(a->z + i);
+        simdStore(result->x + i, simdSub(simdMul(vy, az), simdMul(vz, ay)));
+        simdStore(result->y + i, simdSub(simdMul(vz, ax), simdMul(vx, az)));
+        simdStore(result->z + i, simdSub(simdMul(vx, ay), simdMul(vy, ax)));
+    }
+#endif
+    for(; i < a->length; ++i)
+    {
+        x = v->y * a->z[i] - v->z * a->y[i];
+        y = v->z * a->x[i] - v->x * a->z[i];
+        z = v->x * a->y[i] - v->y * a->x[i];
+        result->x[i] = x;
+        result->y[i] = y;
+        result->z[i] = z;
+    }
+}
+
+int arrayCompare(vectorArray* a1, vectorArray* a2)
+{
+    assert(a1->length == a2->length);
+    if(!columnCompare(a1->x, a2->x, a1->length))
+        return 0;
+    if(a1->type != typeVecArray)
+        return 1;
+    return columnCompare(a1->y, a2->y, a1->length) &&
+           columnCompare(a1->z, a2->z, a1->length);
+}
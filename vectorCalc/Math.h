@@ -3,30 +3,96 @@
    linear algebra for the vector calculations.
 */
 
-/* define epsilon for floats comparison */
-#define EPSILON 0.0001
+/* define epsilon for floats comparison; a float has only about seven
+   significant digits, so the single precision build compares looser */
+#ifdef SINGLE_PRECISION
+    #define EPSILON 0.001f
+#else
+    #define EPSILON 0.0001
+#endif
 
-int numberCompare(double, double);
+int numberCompare(real, real);
 int vectorCompare(vector3*, vector3*);
 
+/* Divides two ints, truncating towards zero as C does; returns false,
+   with a quotient of 0, when dividing by zero. */
+int integerDivide(int64, int64, int64*);
+
+/* Int addition, subtraction, multiplication and negation. They are done
+   on the unsigned type, so an overflow wraps around - just like the
+   smallest int divided by -1 does in integerDivide() - instead of
+   being undefined. */
+#define INTEGER_ADD(a, b) ((int64)((unsigned long long)(a) + (unsigned long long)(b)))
+#define INTEGER_SUB(a, b) ((int64)((unsigned long long)(a) - (unsigned long long)(b)))
+#define INTEGER_MUL(a, b) ((int64)((unsigned long long)(a) * (unsigned long long)(b)))
+#define INTEGER_NEG(a)    ((int64)(0 - (unsigned long long)(a)))
+
 /* Creates a new vector with given dimensions */
-vector3* newVector(double, double, double);
+vector3* newVector(real, real, real);
 
 /* Given two vectors, add them together and stores the
    result in the third one. */
 void vectorAdd(vector3*, vector3*, vector3*);
-vector3* vectorAdd_new(vector3*, vector3*);
-
 void vectorSub(vector3*, vector3*, vector3*);
-vector3* vectorSub_new(vector3*, vector3*);
+void vectorScale(vector3*, real, vector3*);
+void vectorNeg(vector3*, vector3*);
+real vectorDot(vector3*, vector3*);
+void vectorCross(vector3*, vector3*, vector3*);
 
-vector3* vectorScale_new(vector3*, double);
+/* The same for the 2- and 4-dimensional vectors, generated from the one
+   template in Math.c; there is no cross product outside 3 dimensions. */
+int vec2Compare(vec2*, vec2*);
+void vec2Add(vec2*, vec2*, vec2*);
+void vec2Sub(vec2*, vec2*, vec2*);
+void vec2Scale(vec2*, real, vec2*);
+void vec2Neg(vec2*, vec2*);
+real vec2Dot(vec2*, vec2*);
 
-void vectorNeg(vector3*, vector3*);
-vector3* vectorNeg_new(vector3*);
+int vec4Compare(vec4*, vec4*);
+void vec4Add(vec4*, vec4*, vec4*);
+void vec4Sub(vec4*, vec4*, vec4*);
+void vec4Scale(vec4*, real, vec4*);
+void vec4Neg(vec4*, vec4*);
+real vec4Dot(vec4*, vec4*);
 
-double vectorDot(vector3*, vector3*);
+/* Whole-array versions of the above, working down the columns with
+   SSE2 or AVX2 where the compiler targets them. The arrays have the same
+   length, and the result may be one of the operands. Arrays of numbers
+   can be added, subtracted, scaled and negated as well. */
+void arrayAdd(vectorArray*, vectorArray*, vectorArray*);
+void arraySub(vectorArray*, vectorArray*, vectorArray*);
+void arrayScale(vectorArray*, real, vectorArray*);
+void arrayNeg(vectorArray*, vectorArray*);
 
-void vectorCross(vector3*, vector3*, vector3*);
-vector3* vectorCross_new(vector3*, vector3*);
+/* Adds the vector to (or subtracts it from) every element. */
+void arrayAddVector(vectorArray*, vector3*, vectorArray*);
+void arraySubVector(vectorArray*, vector3*, vectorArray*);
+void vectorSubArray(vector3*, vectorArray*, vectorArray*);
+
+/* The same for a number and every element of an array of numbers. */
+void arrayAddNumber(vectorArray*, real, vectorArray*);
+void arraySubNumber(vectorArray*, real, vectorArray*);
+void numberSubArray(real, vectorArray*, vectorArray*);
+void arrayDivNumber(vectorArray*, real, vectorArray*);
+void numberDivArray(real, vectorArray*, vectorArray*);
+
+/* Multiplies (or divides) every element by the number at its index in
+   the array of numbers; a vector is divided by scaling it by the
+   reciprocal, as a single one is. The vector versions give an array of
+   vectors, the vector scaled by (or divided by) each number. */
+void arrayMulArray(vectorArray*, vectorArray*, vectorArray*);
+void arrayDivArray(vectorArray*, vectorArray*, vectorArray*);
+void vectorMulArray(vector3*, vectorArray*, vectorArray*);
+void vectorDivArray(vector3*, vectorArray*, vectorArray*);
+
+/* The dot products go into an array of numbers. */
+void arrayDot(vectorArray*, vectorArray*, vectorArray*);
+void arrayDotVector(vectorArray*, vector3*, vectorArray*);
+
+void arrayCross(vectorArray*, vectorArray*, vectorArray*);
+void arrayCrossVector(vectorArray*, vector3*, vectorArray*);
+void vectorCrossArray(vector3*, vectorArray*, vectorArray*);
 
+/* True when every element of the first array compares equal to the one
+   of the second, as vectorCompare() or numberCompare() would have it. */
+int arrayCompare(vectorArray*, vectorArray*);
@@ -0,0 +1,841 @@
+/*
+   The optimiser's implementation.
+
+   Every pass takes the tree of a single statement and returns the tree to
+   run instead; nodes are rewritten in place or replaced by new ones built
+   with ParseTreeBuilder.c. A pass must not change what the statement
+   prints, which errors it reports, or any of the values it computes, so
+   operations are folded with exactly the arithmetic interpret() uses and
+   anything with the wrong operand types is left alone (the type checker
+   has rejected such statements before they get here). The one exception
+   is the algebraic simplifier, whose identities hold for finite values
+   (a >< a is only the zero vector if no component is infinite) and may
+   lose the sign of a zero (v * 0).
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "Optimiser.h"
+#include "ParseTreeBuilder.h"
+#include "SymbolTable.h"
+#include "vectorCalc.tab.h"
+#include "Math.h"
+
+/* A growable list of nodes (or of anything else pointer-sized). */
+typedef struct {
+    void** items;
+    int count, capacity;
+} nodeList;
+
+/* A subexpression that can be reused, with every place it occurs. */
+typedef struct {
+    nodeType* expression;       /* the first occurrence */
+    int type;                   /* its type */
+    int first;                  /* the statement it first occurs in */
+    nodeList slots;             /* the nodeType* fields pointing at it */
+} cseEntry;
+
+/* functions prototypes */
+int isConstant(nodeType*);
+nodeType* foldOperator(nodeType*);
+int foldCondition(nodeType*, int*);
+nodeType* emptyStatement(void);
+void addItem(nodeList*, void*);
+void flattenBlock(nodeType*, nodeList*);
+nodeType* buildBlock(nodeList*);
+int expressionType(nodeType*);
+int sameExpression(nodeType*, nodeType*);
+int readsAny(nodeType*, nodeList*);
+void collectAssigned(nodeType*, nodeList*);
+int containsAssignment(nodeType*);
+char* temporaryName(char*);
+void collectSubexpressions(nodeList*, nodeList*, nodeType**, int);
+nodeType* eliminateInBlock(nodeType*);
+void hoistFrom(nodeType**, nodeList*, nodeList*, int);
+int isNumber(nodeType*, real);
+nodeType* zeroOf(int);
+nodeType* simplifyOperator(nodeType*);
+
+/* counts the temporaries, to give them unique names */
+int temporaryCount = 0;
+
+nodeType* optimise(nodeType* p)
+{
+    p = foldConstants(p);
+    p = simplifyExpressions(p);
+    p = hoistInvariants(p);
+    p = eliminateCommonSubexpressions(p);
+    return p;
+}
+
+int isConstant(nodeType* p)
+{
+    return p && (p->type == typeNumConstant || p->type == typeVecConstant ||
+                 p->type == typeIntConstant);
+}
+
+/* the statement that does nothing, as the parser builds it for ';' */
+nodeType* emptyStatement(void)
+{
+    return operator(';', 2, NULL, NULL);
+}
+
+/* works out a comparison of constants; returns false if it isn't one or
+   the types are wrong */
+int foldCondition(nodeType* p, int* value)
+{
+    nodeType *a, *b;
+
+    if(!p || p->type != typeOperator || p->opr.nops != 2)
+        return 0;
+
+    a = p->opr.op[0];
+    b = p->opr.op[1];
+    if(!isConstant(a) || !isConstant(b) || a->type != b->type)
+        return 0;
+
+    /* ints are compared exactly */
+    if(a->type == typeIntConstant)
+        switch(p->opr.oper)
+        {
+            case '<': *value = a->con.data.integer < b->con.data.integer; return 1;
+            case '>': *value = a->con.data.integer > b->con.data.integer; return 1;
+            case GE:  *value = a->con.data.integer >= b->con.data.integer; return 1;
+            case LE:  *value = a->con.data.integer <= b->con.data.integer; return 1;
+            case EQ:  *value = a->con.data.integer == b->con.data.integer; return 1;
+            case NE:  *value = a->con.data.integer != b->con.data.integer; return 1;
+        }
+    else if(a->type == typeNumConstant)
+        switch(p->opr.oper)
+        {
+            case '<': *value = a->con.data.number < b->con.data.number; return 1;
+            case '>': *value = a->con.data.number > b->con.data.number; return 1;
+            case GE:  *value = a->con.data.number >= b->con.data.number; return 1;
+            case LE:  *value = a->con.data.number <= b->con.data.number; return 1;
+            case EQ:  *value = numberCompare(a->con.data.number, b->con.data.number); return 1;
+            case NE:  *value = !numberCompare(a->con.data.number, b->con.data.number); return 1;
+        }
+    else
+        switch(p->opr.oper)
+        {
+            case EQ:  *value = vectorCompare(&a->con.data.vector, &b->con.data.vector); return 1;
+            case NE:  *value = !vectorCompare(&a->con.data.vector, &b->con.data.vector); return 1;
+        }
+    return 0;
+}
+
+/* folds an operator whose operands are constants; returns the node
+   unchanged if it can't be folded */
+nodeType* foldOperator(nodeType* p)
+{
+    nodeEnum num = typeNumConstant, vec = typeVecConstant, in = typeIntConstant;
+    nodeType *a = p->opr.op[0];
+    nodeType *b = p->opr.nops > 1 ? p->opr.op[1] : NULL;
+    vector3 result;
+    int64 quotient;
+
+    if(p->opr.oper == UMINUS)
+    {
+        if(!isConstant(a)) return p;
+        if(a->type == num)
+            return constantNum(-a->con.data.number);
+        if(a->type == in)
+            return constantInt(INTEGER_NEG(a->con.data.integer));
+        vectorNeg(&a->con.data.vector, &result);
+        return constantVec(result.x, result.y, result.z);
+    }
+
+    if(p->opr.oper == TO_NUMBER)
+    {
+        if(!a || a->type != in) return p;
+        return constantNum((real)a->con.data.integer);
+    }
+
+    if(!isConstant(a) || !isConstant(b)) return p;
+
+#define BOTH(t1, t2) (a->type == (t1) && b->type == (t2))
+    switch(p->opr.oper)
+    {
+        case '+':
+            if(BOTH(in, in))
+                return constantInt(INTEGER_ADD(a->con.data.integer, b->con.data.integer));
+            if(BOTH(num, num))
+                return constantNum(a->con.data.number + b->con.data.number);
+            if(BOTH(vec, vec))
+            {
+                vectorAdd(&a->con.data.vector, &b->con.data.vector, &result);
+                return constantVec(result.x, result.y, result.z);
+            }
+            break;
+
+        case '-':
+            if(BOTH(in, in))
+                return constantInt(INTEGER_SUB(a->con.data.integer, b->con.data.integer));
+            if(BOTH(num, num))
+                return constantNum(a->con.data.number - b->con.data.number);
+            if(BOTH(vec, vec))
+            {
+                vectorSub(&a->con.data.vector, &b->con.data.vector, &result);
+                return constantVec(result.x, result.y, result.z);
+            }
+            break;
+
+        case '*':
+            if(BOTH(in, in))
+                return constantInt(INTEGER_MUL(a->con.data.integer, b->con.data.integer));
+            if(BOTH(num, num))
+                return constantNum(a->con.data.number * b->con.data.number);
+            if(BOTH(num, vec))
+            {
+                vectorScale(&b->con.data.vector, a->con.data.number, &result);
+                return constantVec(result.x, result.y, result.z);
+            }
+            if(BOTH(vec, num))
+            {
+                vectorScale(&a->con.data.vector, b->con.data.number, &result);
+                return constantVec(result.x, result.y, result.z);
+            }
+            break;
+
+        case '/':
+            /* a division by zero is left to report its error */
+            if(BOTH(in, in) && integerDivide(a->con.data.integer, b->con.data.integer, &quotient))
+                return constantInt(quotient);
+            if(BOTH(num, num))
+                return constantNum(a->con.data.number / b->con.data.number);
+            /* vectors are scaled by the reciprocal, just like interpret() */
+            if(BOTH(num, vec))
+            {
+                vectorScale(&b->con.data.vector, 1/a->con.data.number, &result);
+                return constantVec(result.x, result.y, result.z);
+            }
+            if(BOTH(vec, num))
+            {
+                vectorScale(&a->con.data.vector, 1/b->con.data.number, &result);
+                return constantVec(result.x, result.y, result.z);
+            }
+            break;
+
+        case CROSS:
+            if(BOTH(vec, vec))
+            {
+                vectorCross(&a->con.data.vector, &b->con.data.vector, &result);
+                return constantVec(result.x, result.y, result.z);
+            }
+            break;
+
+        case DOT:
+            if(BOTH(vec, vec))
+                return constantNum(vectorDot(&a->con.data.vector, &b->con.data.vector));
+            break;
+    }
+#undef BOTH
+
+    return p;
+}
+
+nodeType* foldConstants(nodeType* p)
+{
+    int i, condition;
+
+    if(!p || p->type != typeOperator)
+        return p;
+
+    /* the operands first, so constants fold bottom-up; the assigned
+       variable is left alone */
+    for(i = p->opr.oper == '=' ? 1 : 0; i < p->opr.nops; ++i)
+        p->opr.op[i] = foldConstants(p->opr.op[i]);
+
+    switch(p->opr.oper)
+    {
+        case IF:
+            if(!foldCondition(p->opr.op[0], &condition))
+                return p;
+            if(condition)
+                return p->opr.op[1] ? p->opr.op[1] : emptyStatement();
+            /* this can be an if-else */
+            if(p->opr.nops > 2 && p->opr.op[2])
+                return p->opr.op[2];
+            return emptyStatement();
+
+        case WHILE:
+            /* a loop that never runs goes; one that never ends stays */
+            if(foldCondition(p->opr.op[0], &condition) && !condition)
+                return emptyStatement();
+            return p;
+
+        case PRINT:
+        case ';':
+        case SEQUENCE:
+        case '=':
+            return p;
+    }
+
+    return foldOperator(p);
+}
+
+/* true if the node is the number or int constant */
+int isNumber(nodeType* p, real number)
+{
+    return p && ((p->type == typeNumConstant && p->con.data.number == number) ||
+                 (p->type == typeIntConstant && p->con.data.integer == number));
+}
+
+nodeType* zeroOf(int type)
+{
+    switch(type)
+    {
+        case typeVecConstant:   return constantVec(0, 0, 0);
+        case typeIntConstant:   return constantInt(0);
+    }
+    return constantNum(0);
+}
+
+/* applies the identities to an operator whose operands are simplified
+   already; only operands free of type errors are dropped, so no run time
+   error goes missing */
+nodeType* simplifyOperator(nodeType* p)
+{
+    int num = typeNumConstant, vec = typeVecConstant, in = typeIntConstant;
+    nodeType *a = p->opr.op[0];
+    nodeType *b = p->opr.nops > 1 ? p->opr.op[1] : NULL;
+    int typeA = expressionType(a), typeB = expressionType(b);
+    real reciprocal;
+
+    switch(p->opr.oper)
+    {
+        case UMINUS:
+            /* -(-v) is v, however deep the nesting */
+            if(a && a->type == typeOperator && a->opr.oper == UMINUS && typeA != -1)
+                return a->opr.op[0];
+            break;
+
+        case '+':
+            /* a + (-b) is a - b */
+            if(b && b->type == typeOperator && b->opr.oper == UMINUS &&
+               expressionType(p) != -1)
+                return simplifyOperator(operator('-', 2, a, b->opr.op[0]));
+            break;
+
+        case '-':
+            /* a - (-b) is a + b */
+            if(b && b->type == typeOperator && b->opr.oper == UMINUS &&
+               expressionType(p) != -1)
+                return simplifyOperator(operator('+', 2, a, b->opr.op[0]));
+            break;
+
+        case CROSS:
+            /* the cross product of a vector with itself */
+            if(typeA == vec && sameExpression(a, b))
+                return zeroOf(vec);
+            break;
+
+        case '*':
+            if(isNumber(b, 1) && (typeA == num || typeA == vec || typeA == in))
+                return a;
+            if(isNumber(a, 1) && (typeB == num || typeB == vec || typeB == in))
+                return b;
+            if(isNumber(b, 0) && (typeA == num || typeA == vec || typeA == in))
+                return zeroOf(typeA);
+            if(isNumber(a, 0) && (typeB == num || typeB == vec || typeB == in))
+                return zeroOf(typeB);
+            break;
+
+        case '/':
+            /* vectors are divided by scaling with the reciprocal anyway;
+               for numbers that is only exact for powers of two */
+            if(typeA == vec && b && b->type == typeNumConstant)
+                return simplifyOperator(operator('*', 2, a, constantNum(1/b->con.data.number)));
+            if(typeB == vec && a && a->type == typeNumConstant)
+                return simplifyOperator(operator('*', 2, b, constantNum(1/a->con.data.number)));
+            if(typeA == num && b && b->type == typeNumConstant)
+            {
+                int exponent;
+                reciprocal = 1/b->con.data.number;
+                if(reciprocal - reciprocal == 0 && reciprocal != 0 &&
+                   fabs(frexp(b->con.data.number, &exponent)) == 0.5 &&
+                   fabs(frexp(reciprocal, &exponent)) == 0.5)
+                    return simplifyOperator(operator('*', 2, a, constantNum(reciprocal)));
+            }
+            break;
+    }
+
+    return foldOperator(p);
+}
+
+nodeType* simplifyExpressions(nodeType* p)
+{
+    int i;
+    nodeType* operand;
+
+    if(!p || p->type != typeOperator) return p;
+
+    /* bottom-up, leaving the assigned variable alone */
+    for(i = p->opr.oper == '=' ? 1 : 0; i < p->opr.nops; ++i)
+    {
+        operand = simplifyExpressions(p->opr.op[i]);
+
+        /* print labels a bare variable with its name, so don't turn
+           the value printed into one */
+        if(p->opr.oper == PRINT && operand && operand->type == typeId &&
+           p->opr.op[i]->type != typeId)
+            continue;
+        p->opr.op[i] = operand;
+    }
+
+    switch(p->opr.oper)
+    {
+        case WHILE:
+        case IF:
+        case PRINT:
+        case ';':
+        case SEQUENCE:
+        case '=':
+            return p;
+    }
+    return simplifyOperator(p);
+}
+
+void addItem(nodeList* list, void* item)
+{
+    if(list->count == list->capacity)
+    {
+        list->capacity = list->capacity ? list->capacity * 2 : 8;
+        if((list->items = realloc(list->items, list->capacity * sizeof(void*))) == NULL)
+            yyerror("Out of memory encountered.");
+        assert(list->items);
+    }
+    list->items[list->count++] = item;
+}
+
+/* lists the statements of a block, in order, skipping the empty ones */
+void flattenBlock(nodeType* p, nodeList* statements)
+{
+    int i;
+
+    if(!p) return;
+
+    if(p->type == typeOperator && (p->opr.oper == ';' || p->opr.oper == SEQUENCE))
+    {
+        for(i = 0; i < p->opr.nops; ++i)
+            flattenBlock(p->opr.op[i], statements);
+    }
+    else
+        addItem(statements, p);
+}
+
+/* puts the statements back into a block, as the parser does */
+nodeType* buildBlock(nodeList* statements)
+{
+    nodeType *block = NULL;
+    int i;
+
+    if(statements->count == 0)
+        return emptyStatement();
+    if(statements->count == 1)
+        return statements->items[0];
+
+    for(i = 0; i < statements->count; ++i)
+        block = sequence(block, statements->items[i]);
+    return block;
+}
+
+/* the type of an expression that only reads declared variables and
+   constants, and is free of type errors; -1 for anything else */
+int expressionType(nodeType* p)
+{
+    int num = typeNumConstant, vec = typeVecConstant, in = typeIntConstant;
+    int t1, t2;
+
+    if(!p) return -1;
+
+    switch(p->type)
+    {
+        case typeNumConstant:
+        case typeVecConstant:
+        case typeIntConstant:
+            return p->type;
+
+        case typeId:
+            if(!p->id.symbol || p->id.symbol->type != p->id.idType)
+                return -1;
+            return p->id.idType;
+
+        case typeOperator:
+            break;
+
+        default:
+            return -1;
+    }
+
+    t1 = expressionType(p->opr.op[0]);
+    if(t1 == -1) return -1;
+
+    if(p->opr.oper == UMINUS)
+        return t1;
+
+    if(p->opr.oper == TO_NUMBER)
+        return t1 == in ? num : -1;
+
+    if(p->opr.nops != 2) return -1;
+    t2 = expressionType(p->opr.op[1]);
+
+    switch(p->opr.oper)
+    {
+        case '+':
+        case '-':
+            return t1 == t2 ? t1 : -1;
+        case '*':
+        case '/':
+            if(t1 == in && t2 == in)
+            {
+                /* only a division that can't fail is free to move */
+                if(p->opr.oper == '*' || (p->opr.op[1]->type == typeIntConstant &&
+                                          p->opr.op[1]->con.data.integer != 0))
+                    return in;
+                return -1;
+            }
+            if(t1 == num && t2 == num) return num;
+            if((t1 == vec && t2 == num) || (t1 == num && t2 == vec)) return vec;
+            return -1;
+        case CROSS:
+            return t1 == vec && t2 == vec ? vec : -1;
+        case DOT:
+            return t1 == vec && t2 == vec ? num : -1;
+    }
+    return -1;
+}
+
+int sameExpression(nodeType* a, nodeType* b)
+{
+    int i;
+
+    if(!a || !b || a->type != b->type)
+        return a == b;
+
+    switch(a->type)
+    {
+        case typeNumConstant:
+            return a->con.data.number == b->con.data.number;
+        case typeVecConstant:
+            /* a padded vector's w is left out */
+            return !memcmp(&a->con.data.vector, &b->con.data.vector, 3 * sizeof(real));
+        case typeIntConstant:
+            return a->con.data.integer == b->con.data.integer;
+        case typeVec2Constant:
+            return !memcmp(&a->con.data.vector2, &b->con.data.vector2, sizeof(vec2));
+        case typeVec4Constant:
+            return !memcmp(&a->con.data.vector4, &b->con.data.vector4, sizeof(vec4));
+        case typeBool:
+        case typeVecArray:
+        case typeNumArray:
+            /* there are no bool or array constants */
+            return 0;
+        case typeId:
+            return a->id.symbol == b->id.symbol && a->id.idType == b->id.idType;
+        case typeOperator:
+            if(a->opr.oper != b->opr.oper || a->opr.nops != b->opr.nops)
+                return 0;
+            for(i = 0; i < a->opr.nops; ++i)
+                if(!sameExpression(a->opr.op[i], b->opr.op[i]))
+                    return 0;
+            return 1;
+    }
+    return 0;
+}
+
+/* true if the expression reads any of the listed symbol table entries */
+int readsAny(nodeType* p, nodeList* symbols)
+{
+    int i;
+
+    if(!p) return 0;
+
+    if(p->type == typeId)
+    {
+        for(i = 0; i < symbols->count; ++i)
+            if(symbols->items[i] == p->id.symbol)
+                return 1;
+        return 0;
+    }
+
+    if(p->type == typeOperator)
+        for(i = 0; i < p->opr.nops; ++i)
+            if(readsAny(p->opr.op[i], symbols))
+                return 1;
+    return 0;
+}
+
+/* lists the entries of the variables the tree assigns */
+void collectAssigned(nodeType* p, nodeList* symbols)
+{
+    int i;
+
+    if(!p || p->type != typeOperator) return;
+
+    /* setting an element assigns to the whole array */
+    if((p->opr.oper == '=' || p->opr.oper == INDEX_ASSIGN) && p->opr.op[0]->id.symbol)
+        addItem(symbols, p->opr.op[0]->id.symbol);
+
+    for(i = 0; i < p->opr.nops; ++i)
+        collectAssigned(p->opr.op[i], symbols);
+}
+
+int containsAssignment(nodeType* p)
+{
+    nodeList symbols = { NULL, 0, 0 };
+    int found;
+
+    collectAssigned(p, &symbols);
+    found = symbols.count > 0;
+    free(symbols.items);
+    return found;
+}
+
+/* a fresh variable name; user identifiers can't start with '_' */
+char* temporaryName(char* prefix)
+{
+    char *name = malloc(strlen(prefix) + 16);
+
+    if(name == NULL)
+        yyerror("Out of memory encountered.");
+    assert(name);
+    sprintf(name, "_%s%d", prefix, ++temporaryCount);
+    return name;
+}
+
+/* records the reusable subexpressions under the field, largest first,
+   in the list of every entry and in that of the ones still available;
+   an expression that is already available isn't looked into again */
+void collectSubexpressions(nodeList* live, nodeList* entries, nodeType** slot, int statement)
+{
+    nodeType *p = *slot;
+    int i, type;
+
+    if(!p || p->type != typeOperator) return;
+
+    type = expressionType(p);
+    if(type == typeNumConstant || type == typeVecConstant || type == typeIntConstant)
+    {
+        cseEntry *entry;
+
+        for(i = 0; i < live->count; ++i)
+        {
+            entry = live->items[i];
+            if(sameExpression(entry->expression, p))
+            {
+                addItem(&entry->slots, slot);
+                return;
+            }
+        }
+
+        if((entry = calloc(1, sizeof(cseEntry))) == NULL)
+            yyerror("Out of memory encountered.");
+        assert(entry);
+        entry->expression = p;
+        entry->type = type;
+        entry->first = statement;
+        addItem(&entry->slots, slot);
+        addItem(entries, entry);
+        addItem(live, entry);
+    }
+
+    for(i = 0; i < p->opr.nops; ++i)
+        collectSubexpressions(live, entries, &p->opr.op[i], statement);
+}
+
+nodeType* eliminateCommonSubexpressions(nodeType* p)
+{
+    return eliminateInBlock(p);
+}
+
+nodeType* eliminateInBlock(nodeType* p)
+{
+    nodeList statements = { NULL, 0, 0 };
+    nodeList entries = { NULL, 0, 0 };
+    nodeList live = { NULL, 0, 0 };
+    nodeList *definitions;
+    nodeList result = { NULL, 0, 0 };
+    int i, j, k;
+
+    flattenBlock(p, &statements);
+
+    for(i = 0; i < statements.count; ++i)
+    {
+        nodeType *s = statements.items[i];
+        nodeList assigned = { NULL, 0, 0 };
+
+        if(s->type == typeOperator && (s->opr.oper == IF || s->opr.oper == WHILE))
+        {
+            /* the branches and loop bodies are blocks of their own */
+            for(j = 1; j < s->opr.nops; ++j)
+                s->opr.op[j] = eliminateInBlock(s->opr.op[j]);
+        }
+        else if(s->type == typeOperator && s->opr.oper == '=' &&
+                !containsAssignment(s->opr.op[1]))
+            collectSubexpressions(&live, &entries, &s->opr.op[1], i);
+        else if(s->type == typeOperator && s->opr.oper == PRINT &&
+                !containsAssignment(s))
+        {
+            /* a variable in place of the printed expression would be
+               printed with its name */
+            nodeType *toPrint = s->opr.op[0];
+            if(toPrint && toPrint->type == typeOperator)
+                for(j = 0; j < toPrint->opr.nops; ++j)
+                    collectSubexpressions(&live, &entries, &toPrint->opr.op[j], i);
+        }
+        else if(!containsAssignment(s))
+            collectSubexpressions(&live, &entries, (nodeType**)&statements.items[i], i);
+
+        /* whatever reads a variable the statement assigns is stale now,
+           and is no longer looked through - which keeps long blocks of
+           assignments linear */
+        collectAssigned(s, &assigned);
+        if(assigned.count)
+        {
+            for(j = k = 0; j < live.count; ++j)
+            {
+                cseEntry *entry = live.items[j];
+                if(!readsAny(entry->expression, &assigned))
+                    live.items[k++] = entry;
+            }
+            live.count = k;
+        }
+        free(assigned.items);
+    }
+
+    /* every repeated subexpression goes into a temporary defined just
+       before the statement it first occurs in; the smaller ones were
+       found later, and come first */
+    definitions = calloc(statements.count + 1, sizeof(nodeList));
+    assert(definitions);
+    for(j = 0; j < entries.count; ++j)
+    {
+        cseEntry *entry = entries.items[j];
+
+        if(entry->slots.count > 1)
+        {
+            char *name = temporaryName("cse");
+            nodeList *before = &definitions[entry->first];
+            nodeType *definition = operator('=', 2, id(entry->type, name),
+                                             entry->expression);
+
+            for(k = 0; k < entry->slots.count; ++k)
+                *(nodeType**)entry->slots.items[k] = id(-1, name);
+
+            /* put it in front of the ones already there */
+            addItem(before, NULL);
+            memmove(before->items + 1, before->items,
+                    (before->count - 1) * sizeof(void*));
+            before->items[0] = definition;
+        }
+        free(entry->slots.items);
+        free(entry);
+    }
+
+    for(i = 0; i < statements.count; ++i)
+    {
+        for(k = 0; k < definitions[i].count; ++k)
+            addItem(&result, definitions[i].items[k]);
+        addItem(&result, statements.items[i]);
+        free(definitions[i].items);
+    }
+
+    /* the block is only rebuilt if something changed */
+    if(result.count != statements.count)
+        p = buildBlock(&result);
+
+    free(definitions);
+    free(entries.items);
+    free(live.items);
+    free(statements.items);
+    free(result.items);
+    return p;
+}
+
+/* replaces the loop invariant subexpressions under the field with
+   temporaries, adding their definitions to the list */
+void hoistFrom(nodeType** slot, nodeList* assigned, nodeList* definitions, int replaceable)
+{
+    nodeType *p = *slot;
+    int i, type;
+
+    if(!p || p->type != typeOperator) return;
+
+    type = expressionType(p);
+    if(replaceable && (type == typeNumConstant || type == typeVecConstant ||
+                       type == typeIntConstant) &&
+       !readsAny(p, assigned))
+    {
+        nodeType *definition = NULL;
+        char *name;
+
+        /* the same expression shares the temporary */
+        for(i = 0; i < definitions->count && !definition; ++i)
+            if(sameExpression(((nodeType*)definitions->items[i])->opr.op[1], p))
+                definition = definitions->items[i];
+
+        if(!definition)
+        {
+            name = temporaryName("licm");
+            definition = operator('=', 2, id(type, name), p);
+            addItem(definitions, definition);
+        }
+        *slot = id(-1, definition->opr.op[0]->id.id);
+        return;
+    }
+
+    for(i = 0; i < p->opr.nops; ++i)
+    {
+        /* the assigned variable stays, and a variable in place of the
+           printed expression would be printed with its name */
+        if(p->opr.oper == '=' && i == 0) continue;
+        hoistFrom(&p->opr.op[i], assigned, definitions, p->opr.oper != PRINT);
+    }
+}
+
+nodeType* hoistInvariants(nodeType* p)
+{
+    nodeList assigned = { NULL, 0, 0 };
+    nodeList definitions = { NULL, 0, 0 };
+    int i;
+
+    if(!p || p->type != typeOperator) return p;
+
+    switch(p->opr.oper)
+    {
+        case ';':
+        case SEQUENCE:
+        case IF:
+            for(i = 0; i < p->opr.nops; ++i)
+                p->opr.op[i] = hoistInvariants(p->opr.op[i]);
+            return p;
+
+        case WHILE:
+            break;
+
+        default:
+            return p;
+    }
+
+    /* whatever the loop never assigns keeps its value throughout; the
+       expressions are pure, so computing them even when the loop doesn't
+       run changes nothing */
+    collectAssigned(p, &assigned);
+    hoistFrom(&p->opr.op[0], &assigned, &definitions, 1);
+    hoistFrom(&p->opr.op[1], &assigned, &definitions, 1);
+    free(assigned.items);
+
+    /* the loops inside get their own invariants moved in front of them */
+    p->opr.op[1] = hoistInvariants(p->opr.op[1]);
+
+    if(definitions.count)
+    {
+        addItem(&definitions, p);
+        p = buildBlock(&definitions);
+    }
+    free(definitions.items);
+    return p;
+}
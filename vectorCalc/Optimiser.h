@@ -0,0 +1,31 @@
+/*
+   Prototype functions for the optimiser, which rewrites the parse tree
+   of a statement before it is executed.
+*/
+
+#include "ParseTree.h"
+
+/* Runs every optimisation pass over the statement and returns the tree
+   to execute in its place. The nodes it creates come from the same arena
+   as the parser's, and go away with them. */
+nodeType* optimise(nodeType*);
+
+/* Folds the constant subexpressions and drops the IF branches and WHILE
+   loops whose conditions are constant. */
+nodeType* foldConstants(nodeType*);
+
+/* Rewrites expressions with the identities of vectorCalc's operators:
+   a >< a is the zero vector, v * 1 is v, v * 0 is zero, -(-v) is v, and
+   division by a constant becomes multiplication by its reciprocal. */
+nodeType* simplifyExpressions(nodeType*);
+
+/* Evaluates repeated pure subexpressions of a statement, or of the
+   statements of a block, once: each goes into a temporary variable
+   before its first use, as long as its operands aren't assigned in
+   between. */
+nodeType* eliminateCommonSubexpressions(nodeType*);
+
+/* Moves the subexpressions of every WHILE loop that don't depend on the
+   variables it assigns into temporaries computed once, before the
+   loop. */
+nodeType* hoistInvariants(nodeType*);
@@ -16,14 +16,27 @@ typedef enum {
     typeVecConstant,
     typeBool,
     typeId,
-    typeOperator
+    typeOperator,
+    typeIntConstant,
+    typeVecArray,
+    typeNumArray,
+    typeVec2Constant,
+    typeVec4Constant
 } nodeEnum;
 
 /* constants */
 typedef struct {
     nodeEnum type;              /* type of node */
-    double number;              /* value of numeric constant */
-    vector3* vector;            /* value of vector constant */
+    union {
+        real number;            /* value of numeric constant */
+        int64 integer;          /* value of int constant */
+        vector3 vector;         /* value of vector constant */
+        vec2 vector2;           /* value of vec2 constant */
+        vec4 vector4;           /* value of vec4 constant */
+    } data;                     /* the one of the node's type */
+    int whole;                  /* a number constant with a whole value an
+                                   int can hold */
+    int64 wholeValue;           /* that value, exactly as it was written */
 } constantNodeType;
 
 /* identifiers */
@@ -31,6 +44,8 @@ typedef struct {
     nodeEnum type;              /* type of node */
     char* id;                   /* id string */
     int idType;                 /* the type of the id */
+    struct symbolNode* symbol;  /* its symbol table entry, resolved while
+                                   parsing; NULL if it isn't declared */
 } idNodeType;
 
 /* operators */
@@ -38,6 +53,8 @@ typedef struct {
     nodeEnum type;              /* type of node */
     int oper;                   /* operator */
     int nops;                   /* number of operands */
+    int line;                   /* the line a kept statement ends on, for
+                                   its run-time errors; 0 otherwise */
     union nodeTypeTag *op[1];   /* operands (expandable) */
 } operatorNodeType;
 
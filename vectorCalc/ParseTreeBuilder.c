@@ -1,52 +1,120 @@
 #include <assert.h>
+#include <string.h>
 #include "ParseTreeBuilder.h"
 #include "SymbolTable.h"
+#include "vectorCalc.tab.h"
 #include "Math.h"
+#include "Arena.h"
 
-nodeType* constantNum(double value)
+/* all the nodes live in one arena, so the nodes of a statement sit next
+   to each other and are freed together */
+arena nodeArena = { NULL, NULL };
+
+nodeType* constantNum(real value)
 {
     nodeType *p;
 
     /* allocate node */
-    if((p = malloc(sizeof(constantNodeType))) == NULL)
-        yyerror("Out of memory encountered.");
+    p = arenaAlloc(&nodeArena, sizeof(constantNodeType));
 
-    assert(p);
     /* copy information */
     p->type = typeNumConstant;
-    p->con.number = value;
+    p->con.data.number = value;
+    p->con.whole = value >= -9223372036854775808.0 &&
+                   value < 9223372036854775808.0 &&
+                   value == (real)(int64)value;
+    p->con.wholeValue = p->con.whole ? (int64)value : 0;
+
+    return p;
+}
+
+nodeType* constantWhole(int64 value)
+{
+    nodeType *p;
+
+    /* allocate node */
+    p = arenaAlloc(&nodeArena, sizeof(constantNodeType));
+
+    /* copy information; the number may be rounded, the int never is */
+    p->type = typeNumConstant;
+    p->con.data.number = (real)value;
+    p->con.whole = 1;
+    p->con.wholeValue = value;
+
+    return p;
+}
+
+nodeType* constantInt(int64 value)
+{
+    nodeType *p;
+
+    /* allocate node */
+    p = arenaAlloc(&nodeArena, sizeof(constantNodeType));
 
-    /* set the vector to NULL to avoid garbage values */
-    p->con.vector = NULL;
+    /* copy information */
+    p->type = typeIntConstant;
+    p->con.data.integer = value;
 
     return p;
 }
 
-nodeType* constantVec(double x, double y, double z)
+nodeType* constantVec(real x, real y, real z)
 {
     nodeType *p;
 
     /* allocate node */
-    if((p = malloc(sizeof(constantNodeType))) == NULL)
-        yyerror("Out of memory encountered.");
+    p = arenaAlloc(&nodeArena, sizeof(constantNodeType));
 
-    assert(p);
     /* copy information */
     p->type = typeVecConstant;
-    p->con.vector = newVector(x, y, z);
+    p->con.data.vector.x = x;
+    p->con.data.vector.y = y;
+    p->con.data.vector.z = z;
+#ifdef PADDED_VECTORS
+    p->con.data.vector.w = 0;
+#endif
 
     return p;
 }
 
-nodeType* id(int type, char *id)
+nodeType* constantVec2(real x, real y)
 {
     nodeType *p;
 
     /* allocate node */
-    if((p = malloc(sizeof(idNodeType))) == NULL)
-        yyerror("Out of memory encountered.");
+    p = arenaAlloc(&nodeArena, sizeof(constantNodeType));
 
-    assert(p);
+    /* copy information */
+    p->type = typeVec2Constant;
+    p->con.data.vector2.x = x;
+    p->con.data.vector2.y = y;
+
+    return p;
+}
+
+nodeType* constantVec4(real x, real y, real z, real w)
+{
+    nodeType *p;
+
+    /* allocate node */
+    p = arenaAlloc(&nodeArena, sizeof(constantNodeType));
+
+    /* copy information */
+    p->type = typeVec4Constant;
+    p->con.data.vector4.x = x;
+    p->con.data.vector4.y = y;
+    p->con.data.vector4.z = z;
+    p->con.data.vector4.w = w;
+
+    return p;
+}
+
+nodeType* id(int type, char *id)
+{
+    nodeType *p;
+
+    /* allocate node */
+    p = arenaAlloc(&nodeArena, sizeof(idNodeType));
 
     /* copy information */
     p->type = typeId;
@@ -67,6 +135,9 @@ nodeType* id(int type, char *id)
         addId(id, type);
     }
 
+    /* the only lookup by name - execution goes through the entry */
+    p->id.symbol = findEntry(id);
+
     return p;
 }
 
@@ -78,18 +149,16 @@ nodeType* operator(int oper, int nops, ...)
     size_t size;
     int i;
 
-    /* Allocate the node - we're still trying to catch the out of memory
-       error, so need to precalculate the space required for all the
-       suboperators. */
+    /* Allocate the node - need to precalculate the space required for
+       all the suboperators. */
     size = sizeof(operatorNodeType) + (nops - 1) * sizeof(nodeType*);
-    if((p = malloc(size)) == NULL)
-        yyerror("Out of memory encountered.");
+    p = arenaAlloc(&nodeArena, size);
 
-    assert(p);
     /* copy the information */
     p->type = typeOperator;
     p->opr.oper = oper;
     p->opr.nops = nops;
+    p->opr.line = 0;
     
     /* initialise the argument list to point to the first element */
     va_start(listPointer, nops);
@@ -103,20 +172,33 @@ nodeType* operator(int oper, int nops, ...)
 
 }
 
-void freeNode(nodeType* p)
+nodeType* sequence(nodeType* block, nodeType* statement)
 {
-    int i;
+    nodeType *p = block;
+    int count = block ? block->opr.nops : 0;
 
-    /* check if the node to be free is free already; if yes - return */
-    if(!p) return;
+    assert(!block || block->opr.oper == SEQUENCE);
 
-    /* if the node is an operator, free all suboperators */
-    if(p->type == typeOperator)
+    /* the statements are kept in one array, which is moved to one twice
+       its size whenever it fills up - at the powers of two */
+    if(count == 0 || (count & (count - 1)) == 0)
     {
-        for(i = 0; i < p->opr.nops; ++i)
-            freeNode(p->opr.op[i]);
+        p = arenaAlloc(&nodeArena, sizeof(operatorNodeType) +
+                                   (count ? 2 * count - 1 : 0) * sizeof(nodeType*));
+        p->type = typeOperator;
+        p->opr.oper = SEQUENCE;
+        p->opr.nops = count;
+        p->opr.line = 0;
+        if(count)
+            memcpy(p->opr.op, block->opr.op, count * sizeof(nodeType*));
     }
 
-    /* finally, free the node */
-    free(p);
+    p->opr.op[p->opr.nops++] = statement;
+    return p;
+}
+
+void freeNodes(void)
+{
+    /* the blocks are kept for the nodes of the next statement */
+    arenaReset(&nodeArena);
 }
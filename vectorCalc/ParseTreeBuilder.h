@@ -1,12 +1,27 @@
 #include <stdarg.h> /* for variable-length arguments in operators */
 #include "ParseTree.h"
 
-nodeType* constantNum(double);
+nodeType* constantNum(real);
 
-nodeType* constantVec(double, double, double);
+/* An int literal: a number constant that keeps its exact value, for when
+   it becomes an int. */
+nodeType* constantWhole(int64);
+
+nodeType* constantInt(int64);
+
+nodeType* constantVec(real, real, real);
+
+nodeType* constantVec2(real, real);
+
+nodeType* constantVec4(real, real, real, real);
 
 nodeType* id(int, char*);
 
 nodeType* operator(int, int, ...);
 
-void freeNode(nodeType*);
+/* Appends the statement to the SEQUENCE node of a block (NULL starts a
+   new one) and returns the node, which may have moved. */
+nodeType* sequence(nodeType*, nodeType*);
+
+/* Frees every node built so far, all at once. */
+void freeNodes(void);
@@ -4,10 +4,15 @@
 
 	Notes on this version: 
 	- uses standard C rather than object orientation or the STL.
-	- The symbol table is implemented as a singly linked list. 
-    - no optimisations for table searching.
-	- all function calls result in a new table search for the required
-    entry.
+	- The symbol table is implemented as an open-addressing hash table
+    with linear probing; every slot keeps the full hash of its name, so
+    a probe only calls strcmp() when the hashes match.
+	- the table doubles in size whenever it gets half full, which keeps
+    the probe sequences short and the lookup cost constant however many
+    variables a script declares.
+	- entries are allocated in blocks of ENTRY_BLOCK, next to each
+    other rather than scattered over the heap, and never move when the
+    table grows.
 
 	Based largely on code by Allan c. Milne.
 */
@@ -23,27 +28,40 @@
 #include "vectorCalc.tab.h"
 #include "Math.h"
 
-/* A single entry in the symbol table. */
-struct symbolNode {
-	char *name;	                /* the identifier name. */
-    int type;                   /* entry's type. */
-	double numberVal;	        /* scalar value assigned to it. */
-    vector3* vectorVal;         /* vector value assigned to it. */
-	struct symbolNode *next;	/* pointer to next entry in the list. */
-};
-typedef struct symbolNode symbolEntry;
+/* initial number of slots; always a power of two. */
+#define INITIAL_CAPACITY 64
+
+/* number of entries allocated at a time. */
+#define ENTRY_BLOCK 256
+
+/* A slot of the hash table; empty when entry is NULL. */
+typedef struct {
+    unsigned int hash;          /* hash of the entry's name. */
+    symbolEntry *entry;         /* the entry itself. */
+} symbolSlot;
 
 /* internal functions prototypes */
 char* getTypeAsString(int);
-symbolEntry* findEntry(char*);
+unsigned int hashName(char*);
+symbolSlot* findSlot(char*, unsigned int);
+void growTable(void);
 
 /* the Symbol table. */
-symbolEntry* symbolTable = NULL;
+symbolSlot* symbolTable = NULL;
+unsigned int symbolCapacity = 0;    /* number of slots. */
+unsigned int symbolCount = 0;       /* number of entries. */
+symbolEntry* entryBlock = NULL;     /* the block new entries come from. */
+unsigned int entryBlockFree = 0;    /* entries left in that block. */
 
 char* getTypeAsString(int type)
 {
     static char *typeNumConstant_s = "Number\0";
     static char *typeVecConstant_s = "Vector\0";
+    static char *typeIntConstant_s = "Int\0";
+    static char *typeVec2Constant_s = "Vec2\0";
+    static char *typeVec4Constant_s = "Vec4\0";
+    static char *typeVecArray_s    = "Vector[]\0";
+    static char *typeNumArray_s    = "Number[]\0";
     static char *typeId_s          = "Id\0";
     static char *typeOperator_s    = "Operator\0";
 
@@ -51,24 +69,70 @@ char* getTypeAsString(int type)
     {
         case typeNumConstant:   return typeNumConstant_s; break;
         case typeVecConstant:   return typeVecConstant_s; break;
+        case typeIntConstant:   return typeIntConstant_s; break;
+        case typeVec2Constant:  return typeVec2Constant_s; break;
+        case typeVec4Constant:  return typeVec4Constant_s; break;
+        case typeVecArray:      return typeVecArray_s; break;
+        case typeNumArray:      return typeNumArray_s; break;
         case typeId:            return typeId_s; break;
         case typeOperator:      return typeOperator_s; break;
         default:                assert(!"Invalid type specified");
     }
 }
 
-/* local function to find an entry for the specified id name; returns null
- * if not found. */
+/* FNV-1a hash of the id name. */
+unsigned int hashName(char *id) {
+    unsigned int hash = 2166136261u;
+    while(*id)
+    {
+        hash ^= (unsigned char)*id++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* local function to find the slot for the specified id name - either the
+ * one holding its entry or the empty one it would go into. */
+symbolSlot* findSlot(char *id, unsigned int hash) {
+	unsigned int mask = symbolCapacity - 1;
+	unsigned int i = hash & mask;
+	while(symbolTable[i].entry != NULL)
+    {
+        if(symbolTable[i].hash == hash && !strcmp(id, symbolTable[i].entry->name))
+            break;
+		i = (i + 1) & mask;
+	}
+	return &symbolTable[i];
+}
+
+/* finds the entry for the specified id name; returns null if not found. */
 symbolEntry* findEntry(char *id) {
-	symbolEntry *found = NULL;
-	symbolEntry *iterator = symbolTable;
-	while(iterator != NULL)
+	if(symbolTable == NULL) return NULL;
+	return findSlot(id, hashName(id))->entry;
+}
+
+/* local function to double the number of slots, re-inserting the entries
+ * by their stored hashes. */
+void growTable(void) {
+	symbolSlot *oldTable = symbolTable;
+	unsigned int oldCapacity = symbolCapacity;
+	unsigned int i, j, mask;
+
+	symbolCapacity = oldCapacity ? oldCapacity * 2 : INITIAL_CAPACITY;
+	symbolTable = (symbolSlot*) calloc(symbolCapacity, sizeof(symbolSlot));
+	if(symbolTable == NULL)
+        yyerror("Out of memory encountered.");
+	assert(symbolTable);
+
+	mask = symbolCapacity - 1;
+	for(i = 0; i < oldCapacity; ++i)
     {
-        if(!strcmp(id,iterator->name))
-            found = iterator;
-		iterator = iterator->next;
+        if(oldTable[i].entry == NULL) continue;
+        for(j = oldTable[i].hash & mask; symbolTable[j].entry != NULL; j = (j + 1) & mask)
+            ;
+        symbolTable[j] = oldTable[i];
 	}
-	return found;
+	free(oldTable);
 }
 
 /* returns true/false if there is an entry in the table for the specified
@@ -81,19 +145,35 @@ int isDeclared(char *id) {
  * the table. */
 int addId(char *id, int type) {
 	symbolEntry *newEntry;
+	symbolSlot *slot;
+	unsigned int hash = hashName(id);
+
+	/* keep the table at most half full */
+	if(2 * (symbolCount + 1) > symbolCapacity)
+        growTable();
+
+	slot = findSlot(id, hash);
+	if(slot->entry != NULL) return 0;
     
-	if(isDeclared(id)) return 0;
-    
-	newEntry = (symbolEntry*) malloc(sizeof(symbolEntry));
-	newEntry->name = id;
-    switch(type)
+	if(entryBlockFree == 0)
     {
-        case typeNumConstant: newEntry->numberVal = 0; break;
-        case typeVecConstant: newEntry->vectorVal = newVector(0,0,0); break;
+        entryBlock = (symbolEntry*) malloc(ENTRY_BLOCK * sizeof(symbolEntry));
+        if(entryBlock == NULL)
+            yyerror("Out of memory encountered.");
+        assert(entryBlock);
+        entryBlockFree = ENTRY_BLOCK;
     }
+	newEntry = entryBlock++;
+	--entryBlockFree;
+	newEntry->name = id;
+	/* every value starts as zero - an array as an empty one */
+	memset(&newEntry->data, 0, sizeof(newEntry->data));
+	if(type == typeVecArray || type == typeNumArray)
+		newEntry->data.array.type = type;
     newEntry->type = type;
-	newEntry->next = symbolTable;
-	symbolTable = newEntry;
+	slot->hash = hash;
+	slot->entry = newEntry;
+	++symbolCount;
 
 #ifdef DEBUG
     printf("Added a new <%s %s> to symtable\n",
@@ -109,8 +189,11 @@ int getValue(char *id, int type, void *v) {
 	if(entry == NULL) return 0;
     switch(type)
     {
-        case typeNumConstant: *((double*)v) = entry->numberVal; break;
-        case typeVecConstant: *((vector3**)v) = entry->vectorVal; break;
+        case typeNumConstant: *((real*)v) = entry->data.number; break;
+        case typeIntConstant: *((int64*)v) = entry->data.integer; break;
+        case typeVecConstant: *((vector3*)v) = entry->data.vector; break;
+        case typeVec2Constant: *((vec2*)v) = entry->data.vector2; break;
+        case typeVec4Constant: *((vec4*)v) = entry->data.vector4; break;
     }
 	return 1;
 }
@@ -133,24 +216,34 @@ int setValue(char *id, int type, void *v) {
     {
         case typeNumConstant:
         {
-            double number = *((double*)v);
-            entry->numberVal = number;
+            real number = *((real*)v);
+            entry->data.number = number;
 #ifdef DEBUG
             printf("Set <%s %s> to %0.2f to symtable\n",
-                    getTypeAsString(type), id, entry->numberVal);
+                    getTypeAsString(type), id, entry->data.number);
 #endif
             break;
         }
+        case typeIntConstant:
+            entry->data.integer = *((int64*)v);
+            break;
         case typeVecConstant:
         {
+            /* the vector is copied, never aliased */
             vector3 *vector = (vector3*)v;
-            entry->vectorVal = vector;
+            entry->data.vector = *vector;
 #ifdef DEBUG
             printf("Set <%s> to {%0.2f, %0.2f, %0.2f} to symtable\n",
                     id, vector->x, vector->y, vector->z);
 #endif
             break;
         }
+        case typeVec2Constant:
+            entry->data.vector2 = *((vec2*)v);
+            break;
+        case typeVec4Constant:
+            entry->data.vector4 = *((vec4*)v);
+            break;
     }
 	return 1;
 }
@@ -6,6 +6,25 @@
 	Based largely on code by Allan C. Milne.
 */
 
+/* A single entry in the symbol table. Entries never move once added, so
+ * the parse tree refers to them directly instead of by name. */
+struct symbolNode {
+	char *name;	                /* the identifier name. */
+    int type;                   /* entry's type. */
+    union {
+        real number;            /* scalar value assigned to it. */
+        int64 integer;          /* int value assigned to it. */
+        vector3 vector;         /* vector value assigned to it, by value. */
+        vec2 vector2;           /* vec2 value assigned to it. */
+        vec4 vector4;           /* vec4 value assigned to it. */
+        vectorArray array;      /* elements of an array variable. */
+    } data;                     /* the one of the entry's type. */
+};
+typedef struct symbolNode symbolEntry;
+
+/* Returns the entry for the specified id name; NULL if there is none. */
+symbolEntry* findEntry(char *id);
+
 /* Returns true/false if there is an entry in the table for the specified
  * id name. */
 int isDeclared(char *id);
@@ -15,13 +34,14 @@ int isDeclared(char *id);
 int addId(char *id, int type);
 
 /* Sets the v parameter to the value associated in the table with the
- * specified id name; returns false if no table entry exists. */
+ * specified id name (vectors are copied into the vector3 v points at);
+ * returns false if no table entry exists. */
 int getValue(char *id, int type, void *v);
 
 int getType(char *id);
 
-/* Sets the value associated with the specified id name to v; returns false
- * if no table entry exists. */
+/* Sets the value associated with the specified id name to v, copying
+ * vectors; returns false if no table entry exists. */
 int setValue(char *id, int type, void *data);
 
 /* End of symbol table header file. */
@@ -0,0 +1,751 @@
+/*
+   The ahead-of-time compiler's implementation.
+
+   The parse tree of the whole script is translated into a C function,
+   preceded by static copies of the vector3 routines from Math.c so the C
+   compiler can inline them. Every variable becomes a local of its
+   declared type. The source is built into a shared object by the system
+   C compiler ($CC, or cc), which is then loaded with dlopen() and run.
+
+   The shared object is cached next to the script as
+   <script>.<hash>.so, where the hash is taken over the script's content,
+   so an unchanged script is run straight away without being parsed.
+
+   The generated code computes in the interpreter's precision: its
+   numbers and vectors are of the same real type (see Defines.h), and
+   every literal is cast to it.
+
+   Only statically typed scripts without arrays, vec2 or vec4 are
+   translated; for anything else compileScript() fails and the caller
+   interprets the script instead.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <assert.h>
+#include "Transpiler.h"
+#include "SymbolTable.h"
+#include "vectorCalc.tab.h"
+#include "Math.h"
+
+#if !defined(_WIN32)
+
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/* the entry point of the generated code */
+#define ENTRY_POINT "vectorCalcScript"
+
+/* bumped whenever the generated code changes, so objects cached by an
+   older translator aren't run */
+#define TRANSLATOR_VERSION 2
+
+/* the vector layout is part of the cache key as well */
+#ifdef PADDED_VECTORS
+    #define LAYOUT 1
+#else
+    #define LAYOUT 0
+#endif
+
+typedef void (*scriptFunction)(FILE*);
+
+/* the name of the real type, for the generated code */
+#ifdef SINGLE_PRECISION
+    #define REAL_NAME "float"
+#else
+    #define REAL_NAME "double"
+#endif
+
+/* A growable string. */
+typedef struct {
+    char* text;
+    int length, capacity;
+} cBuffer;
+
+/* The state of a single translation. */
+typedef struct {
+    cBuffer declarations;       /* the variables */
+    cBuffer body;               /* the statements */
+    symbolEntry** names;        /* variables declared so far */
+    int nameCount, nameCapacity;
+    int labels;                 /* counter for the generated names */
+    int failed;                 /* set when something can't be translated */
+} cTranslation;
+
+/* The output file defined in main.c */
+extern FILE *dataFile;
+
+/* The vector3 routines of Math.c, in a form the C compiler can inline. */
+static const char *prelude =
+    "#include <stdio.h>\n"
+    "#include <string.h>\n"
+    "\n"
+    "typedef " REAL_NAME " real;\n"
+    "\n"
+    "typedef struct {\n"
+    "    real x, y, z;\n"
+    "} vector3;\n"
+    "\n"
+    "static double fromBits(unsigned long long bits)\n"
+    "{\n"
+    "    double number;\n"
+    "    memcpy(&number, &bits, sizeof(number));\n"
+    "    return number;\n"
+    "}\n"
+    "\n"
+    "static int numberCompare(real n1, real n2)\n"
+    "{\n"
+    "    return n2 - n1 < EPSILON;\n"
+    "}\n"
+    "\n"
+    "static int vectorCompare(vector3 v1, vector3 v2)\n"
+    "{\n"
+    "    return numberCompare(v1.x, v2.x) &&\n"
+    "           numberCompare(v1.y, v2.y) &&\n"
+    "           numberCompare(v1.z, v2.z);\n"
+    "}\n"
+    "\n"
+    "static vector3 newVector(real x, real y, real z)\n"
+    "{\n"
+    "    vector3 v;\n"
+    "    v.x = x; v.y = y; v.z = z;\n"
+    "    return v;\n"
+    "}\n"
+    "\n"
+    "static vector3 vectorAdd(vector3 v1, vector3 v2)\n"
+    "{\n"
+    "    return newVector(v1.x + v2.x, v1.y + v2.y, v1.z + v2.z);\n"
+    "}\n"
+    "\n"
+    "static vector3 vectorSub(vector3 v1, vector3 v2)\n"
+    "{\n"
+    "    return newVector(v1.x - v2.x, v1.y - v2.y, v1.z - v2.z);\n"
+    "}\n"
+    "\n"
+    "static vector3 vectorScale(vector3 v, real s)\n"
+    "{\n"
+    "    return newVector(v.x * s, v.y * s, v.z * s);\n"
+    "}\n"
+    "\n"
+    "static vector3 vectorNeg(vector3 v)\n"
+    "{\n"
+    "    return newVector(-v.x, -v.y, -v.z);\n"
+    "}\n"
+    "\n"
+    "static real vectorDot(vector3 v1, vector3 v2)\n"
+    "{\n"
+    "    return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;\n"
+    "}\n"
+    "\n"
+    "static vector3 vectorCross(vector3 v1, vector3 v2)\n"
+    "{\n"
+    "    return newVector(v1.y * v2.z - v1.z * v2.y,\n"
+    "                     v1.z * v2.x - v1.x * v2.z,\n"
+    "                     v1.x * v2.y - v1.y * v2.x);\n"
+    "}\n"
+    "\n"
+    "static void printNumber(FILE *dataFile, const char *name, real n)\n"
+    "{\n"
+    "    if(name) fprintf(dataFile, \"%s = \", name);\n"
+    "    fprintf(dataFile, \"" NUMBER_FORMAT "\\n\", n);\n"
+    "}\n"
+    "\n"
+    "static void printInteger(FILE *dataFile, const char *name, long long n)\n"
+    "{\n"
+    "    if(name) fprintf(dataFile, \"%s = \", name);\n"
+    "    fprintf(dataFile, \"%lld\\n\", n);\n"
+    "}\n"
+    "\n"
+    "static void printVector(FILE *dataFile, const char *name, vector3 v)\n"
+    "{\n"
+    "    if(name) fprintf(dataFile, \"%s = \", name);\n"
+    "    fprintf(dataFile, \"" VECTOR_FORMAT "\\n\", v.x, v.y, v.z);\n"
+    "}\n"
+    "\n";
+
+/* functions prototypes */
+void append(cBuffer*, const char*, ...);
+void appendNumber(cBuffer*, double);
+unsigned long long hashScript(char*);
+char* cachePath(char*, unsigned long long, char*);
+int runCompiler(char*, char*);
+int runSharedObject(char*);
+int declareVariable(cTranslation*, nodeType*);
+int translateExpression(cTranslation*, cBuffer*, nodeType*);
+void translateStatement(cTranslation*, nodeType*, int);
+
+void append(cBuffer* b, const char* format, ...)
+{
+    va_list listPointer;
+    int needed;
+
+    for(;;)
+    {
+        va_start(listPointer, format);
+        needed = vsnprintf(b->text + b->length, b->capacity - b->length,
+                           format, listPointer);
+        va_end(listPointer);
+
+        if(needed >= 0 && b->length + needed < b->capacity)
+            break;
+
+        /* not enough space - grow and try again */
+        b->capacity = (b->capacity + needed + 1) * 2;
+        if((b->text = realloc(b->text, b->capacity)) == NULL)
+            yyerror("Out of memory encountered.");
+        assert(b->text);
+    }
+    b->length += needed;
+}
+
+/* numbers are written exactly, as double literals cast to real */
+void appendNumber(cBuffer* b, double number)
+{
+    char text[64];
+    unsigned long long bits;
+
+    /* infinities and NaNs (from folded divisions) have no literal, so
+       they are rebuilt from their bits */
+    if(number != number || number - number != 0)
+    {
+        memcpy(&bits, &number, sizeof(bits));
+        append(b, "((real)fromBits(0x%016llxULL))", bits);
+        return;
+    }
+
+    SPRINTF(text, sizeof(text), "%.17g", number);
+    if(!strpbrk(text, ".eE"))
+        append(b, "((real)%s.0)", text);
+    else
+        append(b, "((real)%s)", text);
+}
+
+/* FNV-1a hash of the script's content, the translator's version and
+   the build's precision and vector layout, so differently configured
+   builds don't share cached objects; 0 if the script can't be read */
+unsigned long long hashScript(char* scriptPath)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    FILE *script = fopen(scriptPath, "rb");
+    int ch;
+
+    if(!script) return 0;
+    while((ch = fgetc(script)) != EOF)
+    {
+        hash ^= (unsigned char)ch;
+        hash *= 1099511628211ULL;
+    }
+    hash ^= TRANSLATOR_VERSION;
+    hash *= 1099511628211ULL;
+    hash ^= sizeof(real);
+    hash *= 1099511628211ULL;
+    hash ^= LAYOUT;
+    hash *= 1099511628211ULL;
+    fclose(script);
+    return hash;
+}
+
+/* <script>.<hash>.<extension>; dlopen() needs a slash to not search */
+char* cachePath(char* scriptPath, unsigned long long hash, char* extension)
+{
+    size_t size = strlen(scriptPath) + 64;
+    char *path = malloc(size);
+    int local = strchr(scriptPath, '/') == NULL;
+
+    assert(path);
+    SPRINTF(path, size, "%s%s.%016llx.%s", local ? "./" : "", scriptPath,
+            hash, extension);
+    return path;
+}
+
+/* builds the source into a shared object with $CC (or cc), which may
+   carry its own flags; the arguments are passed to the compiler as they
+   are, without a shell. Returns true if the compiler succeeded */
+int runCompiler(char* sourcePath, char* objectPath)
+{
+    const char *compiler = getenv("CC");
+    char *words, *word, **argv;
+    int argc = 0, status;
+    pid_t child;
+
+    if(!compiler || !*compiler)
+        compiler = "cc";
+
+    /* each word of $CC is an argument; there are at most half as many
+       words as characters, plus the eight added below */
+    words = malloc(strlen(compiler) + 1);
+    argv = malloc((strlen(compiler) / 2 + 9) * sizeof(char*));
+    assert(words && argv);
+    strcpy(words, compiler);
+    for(word = strtok(words, " \t"); word; word = strtok(NULL, " \t"))
+        argv[argc++] = word;
+    argv[argc++] = "-O2";
+    argv[argc++] = "-shared";
+    argv[argc++] = "-fPIC";
+    argv[argc++] = "-o";
+    argv[argc++] = objectPath;
+    argv[argc++] = sourcePath;
+    argv[argc] = NULL;
+
+    child = argc > 6 ? fork() : -1;
+    if(child == 0)
+    {
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+    if(child < 0 || waitpid(child, &status, 0) != child)
+        status = -1;
+
+    free(argv);
+    free(words);
+    return status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int runSharedObject(char* path)
+{
+    void *library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    scriptFunction function;
+
+    if(!library) return 0;
+
+    function = (scriptFunction)dlsym(library, ENTRY_POINT);
+    if(!function)
+    {
+        dlclose(library);
+        return 0;
+    }
+
+    function(dataFile);
+    fflush(dataFile);
+    dlclose(library);
+    return 1;
+}
+
+int runCachedScript(char* scriptPath)
+{
+    unsigned long long hash = hashScript(scriptPath);
+    char *path;
+    int ran = 0;
+
+    if(!hash) return 0;
+
+    path = cachePath(scriptPath, hash, "so");
+    if(access(path, R_OK) == 0)
+        ran = runSharedObject(path);
+    free(path);
+    return ran;
+}
+
+/* gives the variable a C local on its first use; returns false if it is
+   not a declared number or vector */
+int declareVariable(cTranslation* t, nodeType* p)
+{
+    char *name = p->id.id;
+    int type = p->id.idType;
+    int i;
+
+    if(!p->id.symbol || p->id.symbol->type != type)
+        return 0;
+
+    for(i = 0; i < t->nameCount; ++i)
+        if(t->names[i] == p->id.symbol)
+            return 1;
+
+    if(t->nameCount == t->nameCapacity)
+    {
+        t->nameCapacity = t->nameCapacity ? t->nameCapacity * 2 : 16;
+        if((t->names = realloc(t->names, t->nameCapacity * sizeof(symbolEntry*))) == NULL)
+            yyerror("Out of memory encountered.");
+        assert(t->names);
+    }
+    t->names[t->nameCount++] = p->id.symbol;
+
+    switch(type)
+    {
+        case typeNumConstant:
+            append(&t->declarations, "    real v_%s = 0;\n", name);
+            return 1;
+        case typeVecConstant:
+            append(&t->declarations, "    vector3 v_%s = { 0, 0, 0 };\n", name);
+            return 1;
+        case typeIntConstant:
+            append(&t->declarations, "    long long v_%s = 0;\n", name);
+            return 1;
+    }
+    return 0;
+}
+
+/* writes the expression as C; returns its type, or -1 on type errors */
+int translateExpression(cTranslation* t, cBuffer* b, nodeType* p)
+{
+    int num = typeNumConstant, vec = typeVecConstant, in = typeIntConstant;
+    int t1, t2;
+    cBuffer op1, op2;
+    nodeType *divisor;
+
+    if(!p || t->failed) return t->failed = 1, -1;
+
+    switch(p->type)
+    {
+        case typeNumConstant:
+            appendNumber(b, p->con.data.number);
+            return num;
+
+        case typeVecConstant:
+            append(b, "newVector(");
+            appendNumber(b, p->con.data.vector.x);
+            append(b, ", ");
+            appendNumber(b, p->con.data.vector.y);
+            append(b, ", ");
+            appendNumber(b, p->con.data.vector.z);
+            append(b, ")");
+            return vec;
+
+        case typeIntConstant:
+            /* the smallest int has no literal of its own */
+            if(p->con.data.integer == -9223372036854775807LL - 1)
+                append(b, "(-9223372036854775807LL - 1)");
+            else
+                append(b, "%lldLL", (long long)p->con.data.integer);
+            return in;
+
+        case typeId:
+            if(!declareVariable(t, p))
+                return t->failed = 1, -1;
+            append(b, "v_%s", p->id.id);
+            return p->id.idType;
+
+        case typeOperator:
+            break;
+
+        default:
+            return t->failed = 1, -1;
+    }
+
+    memset(&op1, 0, sizeof(op1));
+    memset(&op2, 0, sizeof(op2));
+    t1 = translateExpression(t, &op1, p->opr.op[0]);
+    t2 = p->opr.nops > 1 ? translateExpression(t, &op2, p->opr.op[1]) : -1;
+    if(t->failed)
+    {
+        free(op1.text);
+        free(op2.text);
+        return -1;
+    }
+
+#define BOTH(a, b) (t1 == (a) && t2 == (b))
+    switch(p->opr.oper)
+    {
+        case '=':
+            /* an assignment inside an expression yields true */
+            if(p->opr.op[0]->type != typeId || t1 != t2) break;
+            append(b, "(%s = %s, 1)", op1.text, op2.text);
+            t1 = typeBool;
+            goto done;
+
+        case TO_NUMBER:
+            if(t1 != in) break;
+            append(b, "((real)%s)", op1.text);
+            t1 = num;
+            goto done;
+
+        case UMINUS:
+            /* ints wrap around on overflow, as they do in Math.h */
+            if(t1 == num) append(b, "(-%s)", op1.text);
+            else if(t1 == in) append(b, "((long long)(0 - (unsigned long long)%s))", op1.text);
+            else if(t1 == vec) append(b, "vectorNeg(%s)", op1.text);
+            else break;
+            goto done;
+
+        case '+':
+        case '-':
+            if(BOTH(num, num))
+                append(b, "(%s %c %s)", op1.text, p->opr.oper, op2.text);
+            else if(BOTH(in, in))
+                append(b, "((long long)((unsigned long long)%s %c (unsigned long long)%s))",
+                       op1.text, p->opr.oper, op2.text);
+            else if(BOTH(vec, vec))
+                append(b, "%s(%s, %s)", p->opr.oper == '+' ? "vectorAdd" : "vectorSub",
+                       op1.text, op2.text);
+            else break;
+            goto done;
+
+        case '*':
+        case '/':
+            /* an int division is only translated when its divisor is a
+               constant it can't fail on, since C has nowhere to report
+               the error */
+            divisor = p->opr.op[1];
+            if(BOTH(in, in) && p->opr.oper == '/' &&
+               (divisor->type != typeIntConstant ||
+                divisor->con.data.integer == 0 || divisor->con.data.integer == -1))
+                break;
+
+            if(BOTH(num, num) || (BOTH(in, in) && p->opr.oper == '/'))
+                append(b, "(%s %c %s)", op1.text, p->opr.oper, op2.text);
+            else if(BOTH(in, in))
+                append(b, "((long long)((unsigned long long)%s * (unsigned long long)%s))",
+                       op1.text, op2.text);
+            else if(BOTH(vec, num) && p->opr.oper == '*')
+                append(b, "vectorScale(%s, %s)", op1.text, op2.text);
+            else if(BOTH(num, vec) && p->opr.oper == '*')
+                append(b, "vectorScale(%s, %s)", op2.text, op1.text);
+            /* division scales by the reciprocal, just like interpret() */
+            else if(BOTH(vec, num))
+                append(b, "vectorScale(%s, 1/%s)", op1.text, op2.text);
+            else if(BOTH(num, vec))
+                append(b, "vectorScale(%s, 1/%s)", op2.text, op1.text);
+            else break;
+            if(!BOTH(num, num) && !BOTH(in, in)) t1 = vec;
+            goto done;
+
+        case CROSS:
+            if(!BOTH(vec, vec)) break;
+            append(b, "vectorCross(%s, %s)", op1.text, op2.text);
+            goto done;
+
+        case DOT:
+            if(!BOTH(vec, vec)) break;
+            append(b, "vectorDot(%s, %s)", op1.text, op2.text);
+            t1 = num;
+            goto done;
+
+        case '<':
+        case '>':
+            if(!BOTH(num, num) && !BOTH(in, in)) break;
+            append(b, "(%s %c %s)", op1.text, p->opr.oper, op2.text);
+            t1 = typeBool;
+            goto done;
+
+        case GE:
+        case LE:
+            if(!BOTH(num, num) && !BOTH(in, in)) break;
+            append(b, "(%s %s %s)", op1.text, p->opr.oper == GE ? ">=" : "<=", op2.text);
+            t1 = typeBool;
+            goto done;
+
+        case EQ:
+        case NE:
+            if(BOTH(num, num))
+                append(b, "%snumberCompare(%s, %s)", p->opr.oper == NE ? "!" : "",
+                       op1.text, op2.text);
+            else if(BOTH(vec, vec))
+                append(b, "%svectorCompare(%s, %s)", p->opr.oper == NE ? "!" : "",
+                       op1.text, op2.text);
+            /* ints are compared exactly */
+            else if(BOTH(in, in))
+                append(b, "(%s %s %s)", op1.text, p->opr.oper == NE ? "!=" : "==",
+                       op2.text);
+            else break;
+            t1 = typeBool;
+            goto done;
+    }
+#undef BOTH
+
+    /* a type error or a statement used as an expression */
+    t->failed = 1;
+    t1 = -1;
+
+done:
+    free(op1.text);
+    free(op2.text);
+    return t1;
+}
+
+void translateStatement(cTranslation* t, nodeType* p, int depth)
+{
+    cBuffer expression;
+    int type, i;
+
+    if(!p || t->failed) return;
+
+    memset(&expression, 0, sizeof(expression));
+
+    if(p->type == typeOperator)
+    {
+        switch(p->opr.oper)
+        {
+            case ';':
+            case SEQUENCE:
+                for(i = 0; i < p->opr.nops; ++i)
+                    translateStatement(t, p->opr.op[i], depth);
+                return;
+
+            case '=':
+            {
+                nodeType *lhs = p->opr.op[0];
+
+                type = translateExpression(t, &expression, p->opr.op[1]);
+                if(t->failed || !declareVariable(t, lhs) ||
+                   type != lhs->id.idType)
+                    break;
+                append(&t->body, "%*sv_%s = %s;\n", depth * 4, "", lhs->id.id,
+                       expression.text);
+                free(expression.text);
+                return;
+            }
+
+            case PRINT:
+            {
+                nodeType *toPrint = p->opr.op[0];
+
+                type = translateExpression(t, &expression, toPrint);
+                if(type != typeNumConstant && type != typeVecConstant &&
+                   type != typeIntConstant)
+                    break;
+                append(&t->body, "%*s%s(dataFile, ", depth * 4, "",
+                       type == typeVecConstant ? "printVector" :
+                       type == typeIntConstant ? "printInteger" : "printNumber");
+                if(toPrint->type == typeId)
+                    append(&t->body, "\"%s\", ", toPrint->id.id);
+                else
+                    append(&t->body, "NULL, ");
+                append(&t->body, "%s);\n", expression.text);
+                free(expression.text);
+                return;
+            }
+
+            case IF:
+                type = translateExpression(t, &expression, p->opr.op[0]);
+                if(type != typeBool)
+                    break;
+                append(&t->body, "%*sif(%s)\n%*s{\n", depth * 4, "", expression.text,
+                       depth * 4, "");
+                translateStatement(t, p->opr.op[1], depth + 1);
+                append(&t->body, "%*s}\n", depth * 4, "");
+                /* this can be an if-else */
+                if(p->opr.nops > 2)
+                {
+                    append(&t->body, "%*selse\n%*s{\n", depth * 4, "", depth * 4, "");
+                    translateStatement(t, p->opr.op[2], depth + 1);
+                    append(&t->body, "%*s}\n", depth * 4, "");
+                }
+                free(expression.text);
+                return;
+
+            case WHILE:
+            {
+                int label = t->labels++;
+
+                type = translateExpression(t, &expression, p->opr.op[0]);
+                if(type != typeBool)
+                    break;
+                /* the condition is re-evaluated before each pass of the
+                   body, exactly as interpret() does */
+                append(&t->body, "%*s{\n", depth * 4, "");
+                append(&t->body, "%*sint condition%d = %s;\n", (depth + 1) * 4, "",
+                       label, expression.text);
+                append(&t->body, "%*swhile(condition%d)\n%*s{\n", (depth + 1) * 4, "",
+                       label, (depth + 1) * 4, "");
+                append(&t->body, "%*scondition%d = %s;\n", (depth + 2) * 4, "",
+                       label, expression.text);
+                translateStatement(t, p->opr.op[1], depth + 2);
+                append(&t->body, "%*s}\n%*s}\n", (depth + 1) * 4, "", depth * 4, "");
+                free(expression.text);
+                return;
+            }
+        }
+    }
+
+    if(!t->failed && p->type != typeOperator)
+    {
+        /* a lone value - it only has to be type correct */
+        type = translateExpression(t, &expression, p);
+        append(&t->body, "%*s(void)%s;\n", depth * 4, "", expression.text);
+        free(expression.text);
+        return;
+    }
+
+    if(!t->failed && expression.text == NULL)
+    {
+        /* the rest of the operators are expression statements */
+        type = translateExpression(t, &expression, p);
+        if(!t->failed)
+        {
+            append(&t->body, "%*s(void)%s;\n", depth * 4, "", expression.text);
+            free(expression.text);
+            return;
+        }
+    }
+
+    free(expression.text);
+    t->failed = 1;
+}
+
+int compileScript(nodeType** program, int count, char* scriptPath)
+{
+    cTranslation t;
+    unsigned long long hash = hashScript(scriptPath);
+    char *sourcePath, *temporaryPath, *objectPath, extension[32];
+    FILE *source;
+    int i, ran = 0;
+
+    if(!hash) return 0;
+
+    memset(&t, 0, sizeof(t));
+    for(i = 0; i < count; ++i)
+        translateStatement(&t, program[i], 1);
+    if(t.failed)
+    {
+        free(t.declarations.text);
+        free(t.body.text);
+        free(t.names);
+        return 0;
+    }
+
+    /* the source and the object are built under names of this process
+       and the object is renamed into place only when it's complete, so
+       neither a concurrent run nor a failed build leave a broken one */
+    SPRINTF(extension, sizeof(extension), "%ld.c", (long)getpid());
+    sourcePath = cachePath(scriptPath, hash, extension);
+    SPRINTF(extension, sizeof(extension), "%ld.so", (long)getpid());
+    temporaryPath = cachePath(scriptPath, hash, extension);
+    objectPath = cachePath(scriptPath, hash, "so");
+
+    /* write the translated script */
+    if((source = fopen(sourcePath, "w")) != NULL)
+    {
+        fprintf(source, "/* Generated by vectorCalc --compile from %s */\n\n", scriptPath);
+        fprintf(source, "#define EPSILON ((real)%.17g)\n", (double)EPSILON);
+        fprintf(source, "%s", prelude);
+        fprintf(source, "void " ENTRY_POINT "(FILE *dataFile)\n{\n%s%s}\n",
+                t.declarations.text ? t.declarations.text : "",
+                t.body.text ? t.body.text : "");
+        fclose(source);
+
+        /* build and run it */
+        if(runCompiler(sourcePath, temporaryPath) &&
+           rename(temporaryPath, objectPath) == 0)
+            ran = runSharedObject(objectPath);
+        else
+            remove(temporaryPath);
+        remove(sourcePath);
+    }
+
+    free(sourcePath);
+    free(temporaryPath);
+    free(objectPath);
+    free(t.declarations.text);
+    free(t.body.text);
+    free(t.names);
+    return ran;
+}
+
+#else
+
+/* no shared objects on this platform - scripts are always interpreted */
+int runCachedScript(char* scriptPath)
+{
+    return 0;
+}
+
+int compileScript(nodeType** program, int count, char* scriptPath)
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,16 @@
+/*
+   Prototype functions for the ahead-of-time compiler, which translates
+   a whole script into C and runs it as a shared object.
+*/
+
+#include "ParseTree.h"
+
+/* Runs the shared object an earlier --compile run cached next to the
+   script; returns false if there is none for the script's current
+   content. */
+int runCachedScript(char*);
+
+/* Translates the statements of the script into C, builds them with the
+   system C compiler, caches the shared object next to the script and
+   runs it; returns false if the script can't be translated or built. */
+int compileScript(nodeType**, int, char*);
@@ -0,0 +1,496 @@
+/*
+   The type checker's implementation.
+
+   The types of vectorCalc are known while a script is parsed: constants
+   carry their own, and every variable is declared with one. The checker
+   walks the tree of a statement bottom-up, working out the type of each
+   expression from those of its operands, exactly as interpret() does at
+   run time, and reports the operators whose operands don't fit. An
+   expression with an error in it has no type (-1), and the operators
+   above it don't report it again.
+
+   Once a statement is known to be well-typed, specialise() makes the
+   same walk and replaces each generic operator with the specialised one
+   for its operand types, so the tree walker doesn't have to dispatch on
+   them. The other back ends do their own lowering, and are given the
+   generic tree.
+
+   The checker also makes the conversions between int and number
+   explicit, so no operator ever sees the two mixed: whole-valued
+   constants (and sums and products of them) next to an int become int
+   constants, and otherwise an int meeting a number (or scaling a vector)
+   is wrapped in a TO_NUMBER operator. A number is never silently turned
+   into an int.
+
+   The operators on whole arrays are left generic: each back end hands
+   them to arrayOperator(), which runs one loop over the elements, so
+   there is nothing to gain from specialising them. So are those on vec2
+   and vec4, which go to vectorNOperator() and its unrolled kernels.
+*/
+
+#include <stdio.h>
+#include "TypeChecker.h"
+#include "ParseTreeBuilder.h"
+#include "Array.h"
+#include "VectorN.h"
+#include "vectorCalc.tab.h"
+
+/* The number of errors detected, defined in vectorCalc.y */
+extern int errorCount;
+
+/* functions prototypes */
+int specialisedType(int);
+char* typeErrorMessage(int, int, int);
+int inferType(nodeType*, int);
+int isWholeConstant(nodeType*);
+void makeInteger(nodeType*);
+int isIntOperand(nodeType**, int, char*);
+int arrayType(int, int, int);
+int vectorNType(int, int, int);
+
+int typeCheck(nodeType* p)
+{
+    int errors = errorCount;
+
+    inferType(p, 0);
+    return errorCount == errors;
+}
+
+void specialise(nodeType* p)
+{
+    inferType(p, 1);
+}
+
+/* the type of an operator that has already been specialised, or -1 if it
+   is a generic one */
+int specialisedType(int oper)
+{
+    switch(oper)
+    {
+        case NUM_NEG: case NUM_ADD: case NUM_SUB: case NUM_MUL: case NUM_DIV:
+        case VEC_DOT:
+            return typeNumConstant;
+
+        case INT_NEG: case INT_ADD: case INT_SUB: case INT_MUL: case INT_DIV:
+            return typeIntConstant;
+
+        case VEC_NEG: case VEC_ADD: case VEC_SUB: case VEC_SCALE: case SCALE_VEC:
+        case VEC_DIV: case DIV_VEC: case VEC_CROSS:
+            return typeVecConstant;
+
+        case NUM_LT: case NUM_GT: case NUM_GE: case NUM_LE:
+        case NUM_EQ: case VEC_EQ: case NUM_NE: case VEC_NE:
+        case NUM_ASSIGN: case VEC_ASSIGN: case NUM_PRINT: case VEC_PRINT:
+        case INT_LT: case INT_GT: case INT_GE: case INT_LE: case INT_EQ: case INT_NE:
+        case INT_ASSIGN: case INT_PRINT:
+            return typeBool;
+    }
+    return -1;
+}
+
+/* the specialised form of a generic operator for the types of its
+   operands (the variable and the value for '=', just the first for a
+   unary operator), or 0 if they are wrong */
+int specialisedOperator(int oper, int t1, int t2)
+{
+    int num = typeNumConstant, vec = typeVecConstant, in = typeIntConstant;
+
+    /* an int only ever meets another int */
+    if(t1 == in && t2 == in)
+        switch(oper)
+        {
+            case PRINT:     return INT_PRINT;
+            case UMINUS:    return INT_NEG;
+            case '=':       return INT_ASSIGN;
+            case '+':       return INT_ADD;
+            case '-':       return INT_SUB;
+            case '*':       return INT_MUL;
+            case '/':       return INT_DIV;
+            case '<':       return INT_LT;
+            case '>':       return INT_GT;
+            case GE:        return INT_GE;
+            case LE:        return INT_LE;
+            case EQ:        return INT_EQ;
+            case NE:        return INT_NE;
+        }
+
+    if((t1 != num && t1 != vec) || (t2 != num && t2 != vec))
+        return 0;
+
+    switch(oper)
+    {
+        case PRINT:     return t1 == num ? NUM_PRINT : VEC_PRINT;
+        case UMINUS:    return t1 == num ? NUM_NEG : VEC_NEG;
+
+        case '=':
+            if(t1 != t2) return 0;
+            return t1 == num ? NUM_ASSIGN : VEC_ASSIGN;
+
+        case '+':
+            if(t1 != t2) return 0;
+            return t1 == num ? NUM_ADD : VEC_ADD;
+
+        case '-':
+            if(t1 != t2) return 0;
+            return t1 == num ? NUM_SUB : VEC_SUB;
+
+        case '*':
+            if(t1 == num) return t2 == num ? NUM_MUL : SCALE_VEC;
+            return t2 == num ? VEC_SCALE : 0;
+
+        case '/':
+            if(t1 == num) return t2 == num ? NUM_DIV : DIV_VEC;
+            return t2 == num ? VEC_DIV : 0;
+
+        case CROSS:     return t1 == vec && t2 == vec ? VEC_CROSS : 0;
+        case DOT:       return t1 == vec && t2 == vec ? VEC_DOT : 0;
+
+        case '<':       return t1 == num && t2 == num ? NUM_LT : 0;
+        case '>':       return t1 == num && t2 == num ? NUM_GT : 0;
+        case GE:        return t1 == num && t2 == num ? NUM_GE : 0;
+        case LE:        return t1 == num && t2 == num ? NUM_LE : 0;
+
+        case EQ:
+            if(t1 != t2) return 0;
+            return t1 == num ? NUM_EQ : VEC_EQ;
+
+        case NE:
+            if(t1 != t2) return 0;
+            return t1 == num ? NUM_NE : VEC_NE;
+    }
+    return 0;
+}
+
+int genericOperator(int oper)
+{
+    switch(oper)
+    {
+        case NUM_PRINT: case VEC_PRINT: case INT_PRINT:
+                                            return PRINT;
+        case NUM_ASSIGN: case VEC_ASSIGN: case INT_ASSIGN:
+                                            return '=';
+        case NUM_NEG: case VEC_NEG: case INT_NEG:
+                                            return UMINUS;
+        case NUM_ADD: case VEC_ADD: case INT_ADD:
+                                            return '+';
+        case NUM_SUB: case VEC_SUB: case INT_SUB:
+                                            return '-';
+        case NUM_MUL: case VEC_SCALE: case SCALE_VEC: case INT_MUL:
+                                            return '*';
+        case NUM_DIV: case VEC_DIV: case DIV_VEC: case INT_DIV:
+                                            return '/';
+        case VEC_CROSS:                     return CROSS;
+        case VEC_DOT:                       return DOT;
+        case NUM_LT: case INT_LT:           return '<';
+        case NUM_GT: case INT_GT:           return '>';
+        case NUM_GE: case INT_GE:           return GE;
+        case NUM_LE: case INT_LE:           return LE;
+        case NUM_EQ: case VEC_EQ: case INT_EQ:
+                                            return EQ;
+        case NUM_NE: case VEC_NE: case INT_NE:
+                                            return NE;
+    }
+    return oper;
+}
+
+/* the message interpret() reports when the operands don't fit */
+char* typeErrorMessage(int oper, int t1, int t2)
+{
+    switch(oper)
+    {
+        case PRINT:     return "Wrong argument for printing.";
+        case UMINUS:    return "Wrong argument for negation.";
+        case '=':       return "ERROR: Incompatible types to assign.";
+    }
+
+    if(t1 == typeBool || t2 == typeBool)
+        return "Incompatible types: operation can't be performed on conditions.";
+
+    switch(oper)
+    {
+        case '*':
+        case '/':
+            if(t1 != typeNumConstant && t2 != typeNumConstant)
+                return "ERROR: vector multiplication is undefined.";
+            break;
+
+        case CROSS:
+            if(IS_VECTOR_N(t1) || IS_VECTOR_N(t2))
+                return "ERROR: the cross product is only defined for 3-dimensional vectors.";
+            break;
+
+        case '<':
+        case '>':
+        case GE:
+        case LE:
+            if(t1 != typeNumConstant)
+                return "Incompatible types: operation can't be performed on vectors.";
+            break;
+    }
+    if((IS_VECTOR_N(t1) || IS_VECTOR_N(t2)) && t1 != typeNumConstant && t2 != typeNumConstant)
+        return "Incompatible types: vectors of different dimensions.";
+    return "Incompatible types: vector and a scalar.";
+}
+
+/* true for a number constant with a whole value an int can hold, or a
+   sum, difference, product or negation of such constants */
+int isWholeConstant(nodeType* p)
+{
+    if(p && p->type == typeOperator)
+        switch(p->opr.oper)
+        {
+            case UMINUS:
+                return isWholeConstant(p->opr.op[0]);
+            case '+':
+            case '-':
+            case '*':
+                return isWholeConstant(p->opr.op[0]) && isWholeConstant(p->opr.op[1]);
+            default:
+                return 0;
+        }
+
+    return p && p->type == typeNumConstant && p->con.whole;
+}
+
+/* turns the constants of a whole constant into int constants, in place */
+void makeInteger(nodeType* p)
+{
+    int i;
+
+    if(p->type == typeOperator)
+        for(i = 0; i < p->opr.nops; ++i)
+            makeInteger(p->opr.op[i]);
+    else
+    {
+        p->con.data.integer = p->con.wholeValue;
+        p->type = typeIntConstant;
+    }
+}
+
+/* true if the operand is an int, or a whole constant that is made one;
+   otherwise the message is reported, unless the operand has an error
+   of its own */
+int isIntOperand(nodeType** operand, int rewrite, char* message)
+{
+    int type = inferType(*operand, rewrite);
+
+    if(type == typeNumConstant && isWholeConstant(*operand))
+    {
+        makeInteger(*operand);
+        type = typeIntConstant;
+    }
+
+    if(type != typeIntConstant && type != -1)
+        yyerror(message);
+    return type == typeIntConstant;
+}
+
+/* the type of an operator with an array operand, reporting the error if
+   the operands don't fit */
+int arrayType(int oper, int t1, int t2)
+{
+    int type;
+
+    switch(oper)
+    {
+        case PRINT:
+            return typeBool;
+
+        case '=':
+            if(t1 == t2)
+                return typeBool;
+            yyerror("ERROR: Incompatible types to assign.");
+            return -1;
+    }
+
+    if((type = arrayOperatorType(oper, t1, t2)) == -1)
+        yyerror("Incompatible types: operation can't be performed on arrays.");
+    return type;
+}
+
+/* the type of an operator with a vec2 or vec4 operand, reporting the
+   error if the operands don't fit */
+int vectorNType(int oper, int t1, int t2)
+{
+    int type;
+
+    switch(oper)
+    {
+        case PRINT:
+            return typeBool;
+
+        case '=':
+            if(t1 == t2)
+                return typeBool;
+            yyerror("ERROR: Incompatible types to assign.");
+            return -1;
+    }
+
+    if((type = vectorNOperatorType(oper, t1, t2)) == -1)
+        yyerror(typeErrorMessage(oper, t1, t2));
+    return type;
+}
+
+/* returns the type of the expression, or -1 if it has a type error;
+   rewrites its operators into their specialised forms if asked to */
+int inferType(nodeType* p, int rewrite)
+{
+    int t1, t2, i, specialised, type;
+
+    /* an empty statement, as interpret() sees it */
+    if(!p) return typeBool;
+
+    switch(p->type)
+    {
+        case typeNumConstant:
+        case typeVecConstant:
+        case typeIntConstant:
+        case typeVec2Constant:
+        case typeVec4Constant:
+            return p->type;
+
+        case typeId:
+            return p->id.idType;
+
+        case typeOperator:
+            break;
+
+        default:
+            return -1;
+    }
+
+    /* the nodes a statement shares may be visited again */
+    if((type = specialisedType(p->opr.oper)) != -1)
+        return type;
+
+    switch(p->opr.oper)
+    {
+        case WHILE:
+        case IF:
+            t1 = inferType(p->opr.op[0], rewrite);
+            if(t1 != typeBool && t1 != -1)
+                yyerror(p->opr.oper == WHILE ?
+                        "WHILE failed, the condition is not of type BOOL." :
+                        "IF failed, the condition is not of type BOOL.");
+
+            /* the body is checked whether or not it would run */
+            for(i = 1; i < p->opr.nops; ++i)
+                inferType(p->opr.op[i], rewrite);
+            return typeBool;
+
+        case ';':
+            inferType(p->opr.op[0], rewrite);
+            return inferType(p->opr.op[1], rewrite);
+
+        case SEQUENCE:
+            for(i = 0; i < p->opr.nops - 1; ++i)
+                inferType(p->opr.op[i], rewrite);
+            return inferType(p->opr.op[i], rewrite);
+
+        case TO_NUMBER:
+            inferType(p->opr.op[0], rewrite);
+            return typeNumConstant;
+
+        case VEC_ARRAY:
+        case NUM_ARRAY:
+            if(!isIntOperand(&p->opr.op[0], rewrite, "ERROR: an array size must be an int."))
+                return -1;
+            return p->opr.oper == VEC_ARRAY ? typeVecArray : typeNumArray;
+
+        case INDEX:
+        case INDEX_ASSIGN:
+            t1 = p->opr.op[0]->id.idType;
+            if(!IS_ARRAY(t1))
+            {
+                yyerror("ERROR: only arrays can be indexed.");
+                return -1;
+            }
+            if(!isIntOperand(&p->opr.op[1], rewrite, "ERROR: an array index must be an int."))
+                return -1;
+            if(p->opr.oper == INDEX)
+                return elementType(t1);
+
+            /* the element assigned; an int going into a number array
+               becomes a number */
+            if((t2 = inferType(p->opr.op[2], rewrite)) == -1)
+                return -1;
+            if(t2 == typeIntConstant && t1 == typeNumArray)
+            {
+                p->opr.op[2] = operator(TO_NUMBER, 1, p->opr.op[2]);
+                t2 = typeNumConstant;
+            }
+            if(t2 != elementType(t1))
+            {
+                yyerror("ERROR: Incompatible types to assign.");
+                return -1;
+            }
+            return typeBool;
+
+        case '=':
+            t2 = inferType(p->opr.op[1], rewrite);
+
+            /* assigning to an undeclared variable does nothing */
+            if(!p->opr.op[0]->id.symbol)
+                return typeBool;
+            t1 = p->opr.op[0]->id.idType;
+            break;
+
+        case PRINT:
+        case UMINUS:
+            t1 = t2 = inferType(p->opr.op[0], rewrite);
+            break;
+
+        default:
+            /* the rest are binary operators */
+            t1 = inferType(p->opr.op[0], rewrite);
+            t2 = inferType(p->opr.op[1], rewrite);
+    }
+
+    /* the error has been reported below */
+    if(t1 == -1 || t2 == -1)
+        return -1;
+
+    /* an int meeting a number or a vector; the variable of an
+       assignment keeps its type, so only the value can change */
+    if(t1 != t2 && (t1 == typeIntConstant || t2 == typeIntConstant) &&
+       t1 != typeBool && t2 != typeBool)
+    {
+        if(t1 == typeIntConstant && isWholeConstant(p->opr.op[1]))
+        {
+            makeInteger(p->opr.op[1]);
+            t2 = t1;
+        }
+        else if(t2 == typeIntConstant && p->opr.oper != '=' &&
+                isWholeConstant(p->opr.op[0]))
+        {
+            makeInteger(p->opr.op[0]);
+            t1 = t2;
+        }
+        else if(t2 == typeIntConstant)
+        {
+            p->opr.op[1] = operator(TO_NUMBER, 1, p->opr.op[1]);
+            t2 = typeNumConstant;
+        }
+        else if(p->opr.oper != '=')
+        {
+            p->opr.op[0] = operator(TO_NUMBER, 1, p->opr.op[0]);
+            t1 = typeNumConstant;
+        }
+    }
+
+    if(IS_ARRAY(t1) || IS_ARRAY(t2))
+        return arrayType(p->opr.oper, t1, t2);
+
+    if(IS_VECTOR_N(t1) || IS_VECTOR_N(t2))
+        return vectorNType(p->opr.oper, t1, t2);
+
+    if(!(specialised = specialisedOperator(p->opr.oper, t1, t2)))
+    {
+        yyerror(typeErrorMessage(p->opr.oper, t1, t2));
+        return -1;
+    }
+
+    if(rewrite)
+        p->opr.oper = specialised;
+    return specialisedType(specialised);
+}
@@ -0,0 +1,24 @@
+/*
+   Prototype functions for the type checker, which infers the type of
+   every expression of a statement before it is executed.
+*/
+
+#include "ParseTree.h"
+
+/* Reports every type error of the statement, with the messages the
+   interpreter would give at run time, and makes its int to number
+   conversions explicit; returns false if there was an error. */
+int typeCheck(nodeType*);
+
+/* Rewrites each operator of a well-typed statement into its specialised
+   form (NUM_ADD, VEC_ADD, VEC_SCALE...), which interpret() runs without
+   looking at the types of the operands. */
+void specialise(nodeType*);
+
+/* The specialised form of a generic operator for the types of its
+   operands (the variable and the value for '=', the one operand twice
+   for print and unary minus), or 0 if they are wrong. */
+int specialisedOperator(int, int, int);
+
+/* The generic operator a specialised one was made from. */
+int genericOperator(int);
@@ -0,0 +1,92 @@
+/*
+   The vec2 and vec4 values' implementation.
+*/
+
+#include "VectorN.h"
+#include "Math.h"
+#include "vectorCalc.tab.h"
+
+int vectorNOperatorType(int oper, int t1, int t2)
+{
+    int num = typeNumConstant;
+
+    switch(oper)
+    {
+        case UMINUS:
+            return IS_VECTOR_N(t1) ? t1 : -1;
+
+        case '+':
+        case '-':
+            return IS_VECTOR_N(t1) && t1 == t2 ? t1 : -1;
+
+        case '*':
+        case '/':
+            /* the vector is scaled, whichever side it is on */
+            if(IS_VECTOR_N(t1) && t2 == num) return t1;
+            if(t1 == num && IS_VECTOR_N(t2)) return t2;
+            return -1;
+
+        case DOT:
+            return IS_VECTOR_N(t1) && t1 == t2 ? num : -1;
+
+        case EQ:
+        case NE:
+            return IS_VECTOR_N(t1) && t1 == t2 ? typeBool : -1;
+    }
+    return -1;
+}
+
+int vectorNOperator(int oper, int t1, void* op1, int t2, void* op2, void* result)
+{
+    int type = vectorNOperatorType(oper, t1, t2);
+    /* the vector operand of a scaling, and what it is scaled by */
+    void *v = IS_VECTOR_N(t1) ? op1 : op2;
+    real s = 0;
+
+    if(type == -1)
+    {
+        yyerror("Incompatible types: operation can't be performed on these vectors.");
+        return -1;
+    }
+
+    /* divided by the reciprocal, just like a vector3 */
+    if(oper == '*' || oper == '/')
+        s = t1 == typeNumConstant ? *(real*)op1 : *(real*)op2;
+    if(oper == '/')
+        s = 1 / s;
+
+    if(t1 == typeVec2Constant || t2 == typeVec2Constant)
+        switch(oper)
+        {
+            case UMINUS:    vec2Neg((vec2*)op1, (vec2*)result); break;
+            case '+':       vec2Add((vec2*)op1, (vec2*)op2, (vec2*)result); break;
+            case '-':       vec2Sub((vec2*)op1, (vec2*)op2, (vec2*)result); break;
+            case '*':
+            case '/':       vec2Scale((vec2*)v, s, (vec2*)result); break;
+            case DOT:       *(real*)result = vec2Dot((vec2*)op1, (vec2*)op2); break;
+            case EQ:        *(int*)result = vec2Compare((vec2*)op1, (vec2*)op2); break;
+            case NE:        *(int*)result = !vec2Compare((vec2*)op1, (vec2*)op2); break;
+        }
+    else
+        switch(oper)
+        {
+            case UMINUS:    vec4Neg((vec4*)op1, (vec4*)result); break;
+            case '+':       vec4Add((vec4*)op1, (vec4*)op2, (vec4*)result); break;
+            case '-':       vec4Sub((vec4*)op1, (vec4*)op2, (vec4*)result); break;
+            case '*':
+            case '/':       vec4Scale((vec4*)v, s, (vec4*)result); break;
+            case DOT:       *(real*)result = vec4Dot((vec4*)op1, (vec4*)op2); break;
+            case EQ:        *(int*)result = vec4Compare((vec4*)op1, (vec4*)op2); break;
+            case NE:        *(int*)result = !vec4Compare((vec4*)op1, (vec4*)op2); break;
+        }
+    return type;
+}
+
+int printVectorN(FILE* file, int type, void* value)
+{
+    if(type == typeVec2Constant)
+        return fprintf(file, VEC2_FORMAT "\n", ((vec2*)value)->x, ((vec2*)value)->y);
+
+    return fprintf(file, VEC4_FORMAT "\n", ((vec4*)value)->x, ((vec4*)value)->y,
+                   ((vec4*)value)->z, ((vec4*)value)->w);
+}
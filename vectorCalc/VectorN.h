@@ -0,0 +1,35 @@
+/*
+   Prototype functions for the 2- and 4-dimensional vectors, vec2 and
+   vec4, next to the 3-dimensional vector3.
+
+   Their operators are left generic by the type checker, just like those
+   of the arrays: every back end hands them to vectorNOperator(), which
+   runs the kernel generated for the dimension in Math.c.
+*/
+
+#ifndef VECTOR_N_H
+#define VECTOR_N_H
+
+#include <stdio.h>
+#include "ParseTree.h"
+
+/* true for the types of the vec2 and vec4 values */
+#define IS_VECTOR_N(type) ((type) == typeVec2Constant || (type) == typeVec4Constant)
+
+/* The type of the result of a vec2 or vec4 operator ('+', '-', '*', '/',
+   DOT, EQ, NE or UMINUS) for the types of its operands (the one operand
+   twice for unary minus), or -1 if they are wrong. There is no cross
+   product outside 3 dimensions. */
+int vectorNOperatorType(int, int, int);
+
+/* Applies a vec2 or vec4 operator to the operands, given by their types
+   and pointers to their values (a vec2, a vec4 or a real). The result -
+   a vector, a real, or an int for EQ and NE - is stored where the last
+   argument points. Returns its type, or -1 once an error has been
+   reported. */
+int vectorNOperator(int, int, void*, int, void*, void*);
+
+/* Prints the vec2 or vec4 value points at on one line. */
+int printVectorN(FILE*, int, void*);
+
+#endif
@@ -0,0 +1,515 @@
+/*
+   The bytecode virtual machine's implementation.
+
+   Values live on a small stack and are held by value, so running a chunk
+   doesn't allocate anything apart from the stack itself. The semantics of
+   every instruction mirror the matching case of interpret().
+*/
+
+#include <stdio.h>
+#include <assert.h>
+#include "VirtualMachine.h"
+#include "ParseTree.h"
+#include "SymbolTable.h"
+#include "vectorCalc.tab.h"
+#include "Math.h"
+#include "Array.h"
+#include "VectorN.h"
+
+/* a value on the machine's stack */
+typedef struct {
+    int type;                       /* simple typing */
+    union {
+        vector3 vector;             /* vector values */
+        vec2 vector2;               /* vec2 values */
+        vec4 vector4;               /* vec4 values */
+        real number;                /* numeric values */
+        int64 integer;              /* int values */
+        vectorArray* array;         /* array values */
+        int bool;                   /* true/false values */
+    } data;
+} vmValue;
+
+/* The output file defined in main.c */
+extern FILE *dataFile;
+
+/* The number of errors detected, defined in vectorCalc.y */
+extern int errorCount;
+
+/* The current line, defined in vectorCalc.l */
+extern int yylinenum;
+
+/* functions prototypes */
+int vmArrayOperator(int, vmValue*, vmValue*);
+int vmVectorNOperator(int, vmValue*, vmValue*);
+
+/* reports the error and stops the chunk */
+#define VM_ERROR(msg) { yyerror(msg); goto halt; }
+
+/* a whole-array operation leaves its result in place of the operands;
+   an error (reported already) stops the chunk */
+#define VM_ARRAY(oper) { if(!vmArrayOperator(oper, a, b)) goto halt; break; }
+
+/* and so does an operation on vec2 or vec4 */
+#define VM_VECTOR_N(oper) { if(!vmVectorNOperator(oper, a, b)) goto halt; break; }
+
+int vmArrayOperator(int oper, vmValue* a, vmValue* b)
+{
+    vectorArray *array = arrayOperator(oper, a->type, &(a->data), b->type, &(b->data));
+
+    if(!array)
+        return 0;
+    a->type = array->type;
+    a->data.array = array;
+    return 1;
+}
+
+int vmVectorNOperator(int oper, vmValue* a, vmValue* b)
+{
+    a->type = vectorNOperator(oper, a->type, &(a->data), b->type, &(b->data), &(a->data));
+    return a->type != -1;
+}
+
+void runChunk(chunk* c)
+{
+    vmValue *stack, *top, *a, *b;
+    instruction *ip = c->code;
+    int errors = errorCount;
+
+    /* safely allocate the stack, the compiler knows its exact size */
+    if((stack = (vmValue*)malloc((c->maxDepth + 1) * sizeof(vmValue))) == NULL)
+        yyerror("Out of memory encountered.");
+
+    assert(stack);
+    /* top always points to the topmost value */
+    top = stack - 1;
+
+    for(;;)
+    {
+        switch(ip->opcode)
+        {
+            case opPushNumber:
+                ++top;
+                top->type = typeNumConstant;
+                top->data.number = c->numbers[ip->arg];
+                break;
+
+            case opPushVector:
+                ++top;
+                top->type = typeVecConstant;
+                top->data.vector = c->vectors[ip->arg];
+                break;
+
+            case opPushInteger:
+                ++top;
+                top->type = typeIntConstant;
+                top->data.integer = c->integers[ip->arg];
+                break;
+
+            case opPushVec2:
+                ++top;
+                top->type = typeVec2Constant;
+                top->data.vector2 = c->vectors2[ip->arg];
+                break;
+
+            case opPushVec4:
+                ++top;
+                top->type = typeVec4Constant;
+                top->data.vector4 = c->vectors4[ip->arg];
+                break;
+
+            case opLoad:
+            {
+                chunkName *name = &c->names[ip->arg];
+
+                ++top;
+                top->type = name->type;
+                if(name->symbol)
+                    switch(name->type)
+                    {
+                        case typeVecConstant:
+                            top->data.vector = name->symbol->data.vector;
+                            break;
+                        case typeNumConstant:
+                            top->data.number = name->symbol->data.number;
+                            break;
+                        case typeIntConstant:
+                            top->data.integer = name->symbol->data.integer;
+                            break;
+                        case typeVec2Constant:
+                            top->data.vector2 = name->symbol->data.vector2;
+                            break;
+                        case typeVec4Constant:
+                            top->data.vector4 = name->symbol->data.vector4;
+                            break;
+                        case typeVecArray:
+                        case typeNumArray:
+                            top->data.array = &name->symbol->data.array;
+                            break;
+                    }
+                break;
+            }
+
+            case opStore:
+            {
+                chunkName *name = &c->names[ip->arg];
+                symbolEntry *symbol = name->symbol;
+                int stored = 0;
+
+                /* Very simple type-checking */
+                if(symbol && name->type != top->type)
+                    VM_ERROR("ERROR: Incompatible types to assign.");
+
+                if(symbol)
+                    switch(top->type)
+                    {
+                        case typeVecConstant:
+                            /* the vector is copied into the variable */
+                            symbol->data.vector = top->data.vector;
+                            stored = 1;
+                            break;
+                        case typeNumConstant:
+                            symbol->data.number = top->data.number;
+                            stored = 1;
+                            break;
+                        case typeIntConstant:
+                            symbol->data.integer = top->data.integer;
+                            stored = 1;
+                            break;
+                        case typeVec2Constant:
+                            symbol->data.vector2 = top->data.vector2;
+                            stored = 1;
+                            break;
+                        case typeVec4Constant:
+                            symbol->data.vector4 = top->data.vector4;
+                            stored = 1;
+                            break;
+                        case typeVecArray:
+                        case typeNumArray:
+                            assignArray(&symbol->data.array, top->data.array);
+                            stored = 1;
+                            break;
+                    }
+                top->type = typeBool;
+                top->data.bool = stored;
+                break;
+            }
+
+            case opPop:
+                if(IS_ARRAY(top->type))
+                    releaseArray(top->data.array);
+                --top;
+                break;
+
+            case opNegate:
+                a = b = top;
+                if(IS_ARRAY(top->type))
+                    VM_ARRAY(UMINUS);
+                if(IS_VECTOR_N(top->type))
+                    VM_VECTOR_N(UMINUS);
+                switch(top->type)
+                {
+                    case typeVecConstant:
+                        vectorNeg(&(top->data.vector), &(top->data.vector));
+                        break;
+                    case typeNumConstant:
+                        top->data.number = -top->data.number;
+                        break;
+                    case typeIntConstant:
+                        top->data.integer = INTEGER_NEG(top->data.integer);
+                        break;
+                    default:
+                        VM_ERROR("Wrong argument for negation.");
+                }
+                break;
+
+            case opToNumber:
+                top->type = typeNumConstant;
+                top->data.number = (real)top->data.integer;
+                break;
+
+            case opNewArray:
+                top->data.array = newArray(ip->arg, top->data.integer);
+                top->type = ip->arg;
+                /* newArray() reports an invalid size itself */
+                if(errorCount != errors)
+                    goto halt;
+                break;
+
+            case opIndex:
+            {
+                chunkName *name = &c->names[ip->arg];
+                int64 index = top->data.integer;
+
+                top->type = elementType(name->type);
+                if(!getElement(&name->symbol->data.array, index, &(top->data)))
+                    goto halt;
+                break;
+            }
+
+            case opStoreIndex:
+                b = top--; a = top;
+                /* the index is replaced by the flag */
+                if(!setElement(&c->names[ip->arg].symbol->data.array, a->data.integer, &(b->data)))
+                    goto halt;
+                a->type = typeBool;
+                a->data.bool = 1;
+                break;
+
+            case opAdd:
+                b = top--; a = top;
+                if(IS_ARRAY(a->type) || IS_ARRAY(b->type))
+                    VM_ARRAY('+');
+                if(IS_VECTOR_N(a->type) || IS_VECTOR_N(b->type))
+                    VM_VECTOR_N('+');
+                if(a->type != b->type)
+                    VM_ERROR("Incompatible types: vector and a scalar.");
+                switch(a->type)
+                {
+                    case typeVecConstant:
+                        vectorAdd(&(a->data.vector), &(b->data.vector), &(a->data.vector));
+                        break;
+                    case typeNumConstant:
+                        a->data.number += b->data.number;
+                        break;
+                    case typeIntConstant:
+                        a->data.integer = INTEGER_ADD(a->data.integer, b->data.integer);
+                        break;
+                    default:
+                        VM_ERROR("Incompatible types: vector and a scalar.");
+                }
+                break;
+
+            case opSub:
+                b = top--; a = top;
+                if(IS_ARRAY(a->type) || IS_ARRAY(b->type))
+                    VM_ARRAY('-');
+                if(IS_VECTOR_N(a->type) || IS_VECTOR_N(b->type))
+                    VM_VECTOR_N('-');
+                if(a->type != b->type)
+                    VM_ERROR("Incompatible types: vector and a scalar.");
+                switch(a->type)
+                {
+                    case typeVecConstant:
+                        vectorSub(&(a->data.vector), &(b->data.vector), &(a->data.vector));
+                        break;
+                    case typeNumConstant:
+                        a->data.number -= b->data.number;
+                        break;
+                    case typeIntConstant:
+                        a->data.integer = INTEGER_SUB(a->data.integer, b->data.integer);
+                        break;
+                    default:
+                        VM_ERROR("Incompatible types: vector and a scalar.");
+                }
+                break;
+
+            case opMul:
+                b = top--; a = top;
+                if(IS_ARRAY(a->type) || IS_ARRAY(b->type))
+                    VM_ARRAY('*');
+                if(IS_VECTOR_N(a->type) || IS_VECTOR_N(b->type))
+                    VM_VECTOR_N('*');
+                if(a->type == typeNumConstant && b->type == typeNumConstant)
+                    a->data.number *= b->data.number;
+                else if(a->type == typeIntConstant && b->type == typeIntConstant)
+                    a->data.integer = INTEGER_MUL(a->data.integer, b->data.integer);
+                else if(a->type == typeNumConstant && b->type == typeVecConstant)
+                {
+                    real s = a->data.number;
+                    a->type = typeVecConstant;
+                    vectorScale(&(b->data.vector), s, &(a->data.vector));
+                }
+                else if(a->type == typeVecConstant && b->type == typeNumConstant)
+                    vectorScale(&(a->data.vector), b->data.number, &(a->data.vector));
+                else
+                    VM_ERROR("ERROR: vector multiplication is undefined.");
+                break;
+
+            case opDiv:
+                b = top--; a = top;
+                if(IS_ARRAY(a->type) || IS_ARRAY(b->type))
+                    VM_ARRAY('/');
+                if(IS_VECTOR_N(a->type) || IS_VECTOR_N(b->type))
+                    VM_VECTOR_N('/');
+                if(a->type == typeNumConstant && b->type == typeNumConstant)
+                    a->data.number /= b->data.number;
+                else if(a->type == typeIntConstant && b->type == typeIntConstant)
+                {
+                    if(!integerDivide(a->data.integer, b->data.integer, &(a->data.integer)))
+                        VM_ERROR("ERROR: integer division by zero.");
+                }
+                else if(a->type == typeNumConstant && b->type == typeVecConstant)
+                {
+                    real s = 1/a->data.number;
+                    a->type = typeVecConstant;
+                    vectorScale(&(b->data.vector), s, &(a->data.vector));
+                }
+                else if(a->type == typeVecConstant && b->type == typeNumConstant)
+                    vectorScale(&(a->data.vector), 1/b->data.number, &(a->data.vector));
+                else
+                    VM_ERROR("ERROR: vector multiplication is undefined.");
+                break;
+
+            case opCross:
+            {
+                vector3 result;
+                b = top--; a = top;
+                if(IS_ARRAY(a->type) || IS_ARRAY(b->type))
+                    VM_ARRAY(CROSS);
+                /* cross product is only defined for vectors */
+                if(a->type != typeVecConstant || b->type != typeVecConstant)
+                    VM_ERROR("Incompatible types: vector and a scalar.");
+                vectorCross(&(a->data.vector), &(b->data.vector), &result);
+                a->data.vector = result;
+                break;
+            }
+
+            case opDot:
+                b = top--; a = top;
+                if(IS_ARRAY(a->type) || IS_ARRAY(b->type))
+                    VM_ARRAY(DOT);
+                if(IS_VECTOR_N(a->type) || IS_VECTOR_N(b->type))
+                    VM_VECTOR_N(DOT);
+                /* dot product is only defined for vectors */
+                if(a->type != typeVecConstant || b->type != typeVecConstant)
+                    VM_ERROR("Incompatible types: vector and a scalar.");
+                a->type = typeNumConstant;
+                a->data.number = vectorDot(&(a->data.vector), &(b->data.vector));
+                break;
+
+            case opLess:
+            case opGreater:
+            case opGreaterEqual:
+            case opLessEqual:
+            {
+                int result = 0;
+                b = top--; a = top;
+
+                /* ints are compared exactly */
+                if(a->type == typeIntConstant && b->type == typeIntConstant)
+                {
+                    switch(ip->opcode)
+                    {
+                        case opLess:         result = a->data.integer <  b->data.integer; break;
+                        case opGreater:      result = a->data.integer >  b->data.integer; break;
+                        case opGreaterEqual: result = a->data.integer >= b->data.integer; break;
+                        case opLessEqual:    result = a->data.integer <= b->data.integer; break;
+                    }
+                    a->type = typeBool;
+                    a->data.bool = result;
+                    break;
+                }
+
+                if(a->type != typeNumConstant)
+                    VM_ERROR("Incompatible types: operation can't be performed on vectors.");
+                if(b->type != typeNumConstant)
+                    VM_ERROR("Incompatible types: vector and a scalar.");
+
+                switch(ip->opcode)
+                {
+                    case opLess:         result = a->data.number <  b->data.number; break;
+                    case opGreater:      result = a->data.number >  b->data.number; break;
+                    case opGreaterEqual: result = a->data.number >= b->data.number; break;
+                    case opLessEqual:    result = a->data.number <= b->data.number; break;
+                }
+                a->type = typeBool;
+                a->data.bool = result;
+                break;
+            }
+
+            case opNotEqual:
+            case opEqual:
+            {
+                int equal = 0;
+                b = top--; a = top;
+                if(IS_VECTOR_N(a->type) || IS_VECTOR_N(b->type))
+                    VM_VECTOR_N(ip->opcode == opEqual ? EQ : NE);
+                if(a->type != b->type)
+                    VM_ERROR("Incompatible types: vector and a scalar.");
+                switch(a->type)
+                {
+                    case typeVecConstant:
+                        equal = vectorCompare(&(a->data.vector), &(b->data.vector));
+                        break;
+                    case typeNumConstant:
+                        equal = numberCompare(a->data.number, b->data.number);
+                        break;
+                    case typeIntConstant:
+                        equal = a->data.integer == b->data.integer;
+                        break;
+                    case typeVecArray:
+                    case typeNumArray:
+                        equal = compareArrays(a->data.array, b->data.array);
+                        break;
+                    default:
+                        VM_ERROR("Incompatible types: vector and a scalar.");
+                }
+                a->type = typeBool;
+                a->data.bool = ip->opcode == opEqual ? equal : !equal;
+                break;
+            }
+
+            case opPrint:
+                if(ip->arg >= 0)
+                    fprintf(dataFile, "%s = ", c->names[ip->arg].name);
+                switch(top->type)
+                {
+                    case typeVecConstant:
+                        fprintf(dataFile, VECTOR_FORMAT "\n",
+                                top->data.vector.x,
+                                top->data.vector.y,
+                                top->data.vector.z);
+                        break;
+                    case typeNumConstant:
+                        fprintf(dataFile, NUMBER_FORMAT "\n", top->data.number);
+                        break;
+                    case typeIntConstant:
+                        fprintf(dataFile, INT64_FORMAT "\n", top->data.integer);
+                        break;
+                    case typeVecArray:
+                    case typeNumArray:
+                        printArray(dataFile, top->data.array);
+                        releaseArray(top->data.array);
+                        break;
+                    case typeVec2Constant:
+                    case typeVec4Constant:
+                        printVectorN(dataFile, top->type, &(top->data));
+                        break;
+                    default:
+                        VM_ERROR("Wrong argument for printing.");
+                }
+                --top;
+                break;
+
+            case opJump:
+                ip = c->code + ip->arg;
+                continue;
+
+            case opJumpIfFalse:
+            case opJumpIfTrue:
+                if(top->type != typeBool)
+                    VM_ERROR("Control statement failed, the condition is not of type BOOL.");
+                if(top--->data.bool == (ip->opcode == opJumpIfTrue))
+                {
+                    ip = c->code + ip->arg;
+                    continue;
+                }
+                break;
+
+            case opLine:
+                yylinenum = ip->arg;
+                break;
+
+            case opHalt:
+                goto halt;
+
+            default:
+                assert(!"Running didn't match any instruction");
+        }
+        ++ip;
+    }
+
+halt:
+    free(stack);
+}
@@ -0,0 +1,9 @@
+/*
+   Prototype functions for the bytecode virtual machine.
+*/
+
+#include "Bytecode.h"
+
+/* Runs the chunk from the first instruction until opHalt
+   or the first runtime error. */
+void runChunk(chunk*);
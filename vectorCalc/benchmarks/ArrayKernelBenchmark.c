@@ -0,0 +1,180 @@
+/*
+   Array kernel benchmark.
+
+   Times every whole-array kernel of Math.c - add, sub, scale, negate,
+   dot, cross and compare - against the scalar loop that runs the same
+   operation one element at a time through the vector3 routines, on a
+   short array that stays in the cache and on a long one that doesn't.
+   Both lengths are odd, so the elements left over after the vector
+   instructions are exercised too; the results of the two are checked to
+   be bit for bit the same.
+
+   Build it from the vectorCalc directory:
+       cc -O2 -I. -o arrayKernelBenchmark benchmarks/ArrayKernelBenchmark.c
+          Math.c Arena.c
+   The kernels use SSE2 by default on x86-64; add -mavx2 for AVX2, or
+   -DNO_SIMD for the scalar kernels. Add -DSINGLE_PRECISION to time the
+   float kernels, which take twice as many elements per instruction.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ParseTree.h"
+#include "Math.h"
+
+/* the number of elements every kernel is timed over, at every length */
+#define ELEMENTS 20000000
+
+typedef enum { kernelAdd, kernelSub, kernelScale, kernelNeg,
+               kernelDot, kernelCross, kernelCompare, kernelCount } kernelEnum;
+
+char *kernelNames[] = { "add", "sub", "scale", "negate", "dot", "cross", "compare" };
+
+/* the scale factor */
+#define SCALE 1.5
+
+/* loads the i-th elements of a and b, and stores r as the i-th result */
+#define LOAD(i)     u.x = a->x[i]; u.y = a->y[i]; u.z = a->z[i]; \
+                    v.x = b->x[i]; v.y = b->y[i]; v.z = b->z[i]
+#define STORE(i)    result->x[i] = r.x; result->y[i] = r.y; result->z[i] = r.z
+
+/* the benchmark has no parser to report errors */
+void yyerror(char *msg)
+{
+    fprintf(stderr, "%s\n", msg);
+    exit(-1);
+}
+
+/* an array of vectors with random components */
+vectorArray* randomArray(int length, unsigned int* random)
+{
+    vectorArray *a = calloc(1, sizeof(vectorArray));
+    real **column[3];
+    int c, i;
+
+    a->type = typeVecArray;
+    a->length = length;
+    column[0] = &a->x; column[1] = &a->y; column[2] = &a->z;
+    for(c = 0; c < 3; ++c)
+    {
+        *column[c] = malloc(length * sizeof(real));
+        for(i = 0; i < length; ++i)
+        {
+            *random = *random * 1103515245u + 12345u;
+            (*column[c])[i] = (real)((int)(*random >> 8) % 2000 - 1000) / 7;
+        }
+    }
+    return a;
+}
+
+/* one element at a time, through the vector3 routines */
+int runScalar(int kernel, vectorArray* a, vectorArray* b, vectorArray* result)
+{
+    vector3 u, v, r;
+    int i, n = a->length, equal = 1;
+
+    switch(kernel)
+    {
+        case kernelAdd:
+            for(i = 0; i < n; ++i) { LOAD(i); vectorAdd(&u, &v, &r); STORE(i); }
+            break;
+        case kernelSub:
+            for(i = 0; i < n; ++i) { LOAD(i); vectorSub(&u, &v, &r); STORE(i); }
+            break;
+        case kernelScale:
+            for(i = 0; i < n; ++i) { LOAD(i); vectorScale(&u, SCALE, &r); STORE(i); }
+            break;
+        case kernelNeg:
+            for(i = 0; i < n; ++i) { LOAD(i); vectorNeg(&u, &r); STORE(i); }
+            break;
+        case kernelDot:
+            for(i = 0; i < n; ++i) { LOAD(i); result->x[i] = vectorDot(&u, &v); }
+            break;
+        case kernelCross:
+            for(i = 0; i < n; ++i) { LOAD(i); vectorCross(&u, &v, &r); STORE(i); }
+            break;
+        case kernelCompare:
+            for(i = 0; i < n && equal; ++i) { LOAD(i); equal = vectorCompare(&u, &v); }
+            break;
+    }
+    return equal;
+}
+
+/* the whole array at once, through the kernels */
+int runBatch(int kernel, vectorArray* a, vectorArray* b, vectorArray* result)
+{
+    switch(kernel)
+    {
+        case kernelAdd:     arrayAdd(a, b, result); break;
+        case kernelSub:     arraySub(a, b, result); break;
+        case kernelScale:   arrayScale(a, SCALE, result); break;
+        case kernelNeg:     arrayNeg(a, result); break;
+        case kernelDot:     arrayDot(a, b, result); break;
+        case kernelCross:   arrayCross(a, b, result); break;
+        case kernelCompare: return arrayCompare(a, b);
+    }
+    return 1;
+}
+
+/* the nanoseconds per element of running the kernel over and over */
+double timeKernel(int (*run)(int, vectorArray*, vectorArray*, vectorArray*),
+                  int kernel, vectorArray* a, vectorArray* b, vectorArray* result,
+                  int* equal)
+{
+    int repeats = ELEMENTS / a->length, i;
+    clock_t start = clock();
+
+    for(i = 0; i < repeats; ++i)
+        *equal += run(kernel, a, b, result);
+    return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / ((double)repeats * a->length);
+}
+
+int sameColumns(vectorArray* a, vectorArray* b, int columns)
+{
+    size_t size = a->length * sizeof(real);
+
+    return !memcmp(a->x, b->x, size) &&
+           (columns == 1 || (!memcmp(a->y, b->y, size) && !memcmp(a->z, b->z, size)));
+}
+
+int main(void)
+{
+    int lengths[] = { 1021, 1000003 };
+    unsigned int random = 12345;
+    int l, kernel, scalarEqual, batchEqual, same;
+    vectorArray *a, *b, *scalarResult, *batchResult;
+    double scalarTime, batchTime;
+
+    printf("%d-byte elements\n", (int)sizeof(real));
+    printf("%-8s %8s %12s %12s %8s %6s\n",
+           "kernel", "length", "scalar ns", "batch ns", "speedup", "same");
+    for(l = 0; l < 2; ++l)
+    {
+        a = randomArray(lengths[l], &random);
+        b = randomArray(lengths[l], &random);
+        scalarResult = randomArray(lengths[l], &random);
+        batchResult = randomArray(lengths[l], &random);
+
+        for(kernel = 0; kernel < kernelCount; ++kernel)
+        {
+            /* equal arrays are compared, so the whole of them is read */
+            vectorArray *other = kernel == kernelCompare ? a : b;
+
+            scalarEqual = batchEqual = 0;
+            scalarTime = timeKernel(runScalar, kernel, a, other, scalarResult, &scalarEqual);
+            batchTime = timeKernel(runBatch, kernel, a, other, batchResult, &batchEqual);
+
+            if(kernel == kernelCompare)
+                same = scalarEqual == batchEqual;
+            else
+                same = sameColumns(scalarResult, batchResult, kernel == kernelDot ? 1 : 3);
+
+            printf("%-8s %8d %12.2f %12.2f %7.2fx %6s\n", kernelNames[kernel],
+                   lengths[l], scalarTime, batchTime, scalarTime / batchTime,
+                   same ? "yes" : "NO");
+        }
+    }
+    return 0;
+}
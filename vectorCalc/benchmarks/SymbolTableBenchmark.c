@@ -0,0 +1,90 @@
+/*
+   Symbol table lookup benchmark.
+
+   Declares 10, 100, ... 1,000,000 variables and, at every size, times
+   the same number of getValue() calls on randomly chosen names. With the
+   hash table the cost per lookup should stay flat; only cache misses on
+   the larger tables make it creep up.
+
+   The same loop is timed again doing nothing but picking the name and
+   hashing it, so the second column shows how much of the first is the
+   benchmark fetching a name it has not touched recently rather than the
+   table itself.
+
+   Build it from the vectorCalc directory, after Yacc has generated
+   vectorCalc.tab.h:
+       cc -O2 -I. -o symbolTableBenchmark benchmarks/SymbolTableBenchmark.c
+          SymbolTable.c Math.c
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ParseTree.h"
+#include "SymbolTable.h"
+
+/* the symbol table's own hash function, defined in SymbolTable.c */
+unsigned int hashName(char*);
+
+/* the number of lookups timed at every table size */
+#define LOOKUPS 10000000
+
+/* the largest table size */
+#define MAX_VARIABLES 1000000
+
+/* the benchmark has no parser to report errors */
+void yyerror(char *msg)
+{
+    fprintf(stderr, "%s\n", msg);
+    exit(-1);
+}
+
+int main(void)
+{
+    /* the names sit in one block, so where they fall does not depend on
+       what the symbol table allocates in between */
+    char *nameText = malloc(MAX_VARIABLES * 16);
+    char **names = malloc(MAX_VARIABLES * sizeof(char*));
+    unsigned int random = 12345;
+    int declared = 0, size, i;
+    real value;
+    double sum = 0;
+    unsigned int hashes = 0;
+    clock_t start;
+    double seconds, nameSeconds;
+
+    printf("%10s %15s %15s\n", "variables", "ns per lookup", "ns per name");
+    for(size = 10; size <= MAX_VARIABLES; size *= 10)
+    {
+        /* grow the table to the next size */
+        for(; declared < size; ++declared)
+        {
+            names[declared] = nameText + 16 * declared;
+            sprintf(names[declared], "v%d", declared);
+            addId(names[declared], typeNumConstant);
+        }
+
+        start = clock();
+        for(i = 0; i < LOOKUPS; ++i)
+        {
+            random = random * 1103515245u + 12345u;
+            getValue(names[(random >> 8) % size], typeNumConstant, &value);
+            sum += value;
+        }
+        seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        start = clock();
+        for(i = 0; i < LOOKUPS; ++i)
+        {
+            random = random * 1103515245u + 12345u;
+            hashes += hashName(names[(random >> 8) % size]);
+        }
+        nameSeconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        printf("%10d %15.1f %15.1f\n", size, seconds * 1e9 / LOOKUPS,
+               nameSeconds * 1e9 / LOOKUPS);
+    }
+
+    /* keep the lookups from being optimised away */
+    return sum != 0 && hashes != 0;
+}
@@ -14,7 +14,10 @@ rem ========================================
 ren %1.yy.c %1yy.c
 ren %1.tab.c %1tab.c
 
-cl /Fe%1.exe /Za main.c %1yy.c %1tab.c Interpreter.c ParseTreeBuilder.c SymbolTable.c Math.c
+rem extra compiler options can follow the name, e.g. /DPADDED_VECTORS
+rem for the padded vector layout or /DSINGLE_PRECISION for floats;
+rem quote them to pass more than one
+cl /Fe%1.exe /Za %~2 main.c %1yy.c %1tab.c Interpreter.c ParseTreeBuilder.c SymbolTable.c Math.c BytecodeCompiler.c VirtualMachine.c ClosureCompiler.c JitCompiler.c Transpiler.c Arena.c Optimiser.c TypeChecker.c LinearTree.c Array.c VectorN.c
 
 rem ========================================
 rem Cleaning up...
@@ -2,9 +2,35 @@
 	Application entry point for the Vector Calculator interpreter.
 	Largely based on code by Allan C. Milne, November 2010.
 
-	Usage: vectorCalc <script-file> {<dataset-file>}
+	Usage: vectorCalc {<options>} <script-file> {<dataset-file>}
 	if <dataset-file> is not supplied then stdout is used.
 
+	Options:
+	 --vm   : compile each statement to bytecode and run it on the
+	          virtual machine (default);
+	 --closure : turn each parse tree node into a pre-resolved handler
+	          with bound operands and run the statement by calling them;
+	 --jit  : compile WHILE loops into x86-64 machine code (Linux only),
+	          interpreting whatever can't be compiled;
+	 --compile : translate the whole script into C, build it with the
+	          system C compiler ($CC or cc) and run the shared object,
+	          which is cached next to the script as <script>.<hash>.so
+	          and reused while the script is unchanged (not on Windows);
+	          scripts that can't be translated are interpreted;
+	 --tree : walk the parse tree directly; kept as the reference
+	          implementation to compare the other modes against;
+	 --linear : lay each statement out in one contiguous buffer, in
+	          post-order with 32-bit indices for pointers, and walk that;
+	 --quicken : walk the parse tree, letting each operator specialise
+	          itself for the types of its operands the first time it
+	          runs, rather than specialising the whole statement first;
+	 --whole-script : parse the whole script before running any of it,
+	          optimise its statements together as one program, then run
+	          that once in the selected mode; by default each statement
+	          is run as soon as it is parsed;
+	 --no-optimise : run the statements exactly as they were parsed,
+	          skipping the optimiser.
+
 	All user messages are output on stderr; avoids conflicts with possible
     dataset output on stdout.
 
@@ -27,12 +53,38 @@
 	 - ParseTree.h : defines data structure for the parse tree nodes.
 	 - ParseTreeBuilder.c/.h : exposes functions for building different
        parse tree branches.
+	 - Arena.c/.h : exposes the arena allocator the parse tree nodes are
+       allocated from.
 	 - Interpreter.c/.h : exposes interpret() function and internal functions
        to interpret different parse tree branches.
+	 - LinearTree.c/.h : exposes functions for laying a parse tree out in
+       one contiguous buffer and walking it.
+	 - Optimiser.c/.h : exposes the passes that rewrite the parse tree of
+       a statement before it is executed.
+	 - TypeChecker.c/.h : exposes functions for rejecting statements with
+       type errors before they are executed, and for specialising their
+       operators for the types of the operands.
+	 - Array.c/.h : exposes functions for creating the array values and
+       for the whole-array operators.
+	 - VectorN.c/.h : exposes the operators of the vec2 and vec4 values,
+       whose kernels Math.c generates for each dimension.
+	 - Bytecode.h : defines the instruction set of the virtual machine.
+	 - BytecodeCompiler.c/.h : exposes functions for lowering a parse tree
+       into bytecode.
+	 - VirtualMachine.c/.h : exposes runChunk() function to run bytecode.
+	 - ClosureCompiler.c/.h : exposes functions for turning a parse tree
+       into closures and running them.
+	 - JitCompiler.c/.h : exposes jitExecute() function to run statements
+       with their loops compiled into machine code.
+	 - Transpiler.c/.h : exposes functions for translating a whole script
+       into C and running it as a cached shared object.
 */
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include "Interpreter.h"
+#include "Transpiler.h"
 
 /* number of errors detected - defined in GenVal.y */
 extern int errorCount;
@@ -43,9 +95,25 @@ extern FILE *yyin;
  /* output file for generated dataset. */
 FILE *dataFile;
 
+/* how the statements are executed - one of executionModeEnum. */
+int executionMode = modeBytecode;
+
+/* whether the statements go through the optimiser. */
+int optimiserEnabled = 1;
+
+/* whether the tree walker quickens its operators as they run. */
+int quickeningEnabled = 0;
+
+/* whether the script is parsed as a whole before it is run. */
+int wholeScriptEnabled = 0;
+
+/* the script file being run. */
+char *scriptPath;
+
 #undef DEBUG
 
 /* internal function prototypes. */
+int parseOptions(int, char**);
 int prologue(int, char**);
 void epilogue(void);
 void openFiles(int, char**);
@@ -56,10 +124,25 @@ int yyparse();
 
 /*--- the vectorCalc application entry point. ---*/
 int main(int argc, char *argv[]) {
+	int options = parseOptions(argc, argv);
+
+	/* hide the options from the rest of the application */
+	argv[options] = argv[0];
+	argv += options;
+	argc -= options;
+
 	if(!prologue(argc, argv))
         exit(-1);
 
 	openFiles(argc, argv);
+	scriptPath = argv[1];
+
+	/* an unchanged script that was compiled before is not parsed at all */
+	if(executionMode == modeCompile && runCachedScript(scriptPath))
+    {
+		closeFiles(argc);
+		exit(0);
+	}
 
 	yyparse(); 	/*** call Yacc parser and subsequent interpreter. **/
 
@@ -68,13 +151,48 @@ int main(int argc, char *argv[]) {
 	return 0; 
 } /* end of main function. */
 
+/* Apply the leading command-line options; returns how many there were. */
+int parseOptions(int argc, char *argv[]) {
+	int i;
+	for(i = 1; i < argc && !strncmp(argv[i], "--", 2); ++i)
+    {
+		if(!strcmp(argv[i], "--tree"))
+			executionMode = modeTree;
+		else if(!strcmp(argv[i], "--vm"))
+			executionMode = modeBytecode;
+		else if(!strcmp(argv[i], "--closure"))
+			executionMode = modeClosure;
+		else if(!strcmp(argv[i], "--jit"))
+			executionMode = modeJit;
+		else if(!strcmp(argv[i], "--compile"))
+			executionMode = modeCompile;
+		else if(!strcmp(argv[i], "--linear"))
+			executionMode = modeLinear;
+		else if(!strcmp(argv[i], "--quicken"))
+        {
+			executionMode = modeTree;
+			quickeningEnabled = 1;
+		}
+		else if(!strcmp(argv[i], "--whole-script"))
+			wholeScriptEnabled = 1;
+		else if(!strcmp(argv[i], "--no-optimise"))
+			optimiserEnabled = 0;
+		else
+        {
+			fprintf(stderr, "unknown option '%s'\n", argv[i]);
+			exit(-1);
+		}
+	}
+	return i - 1;
+} /* end parseOptions function. */
+
 /* Display prologue information and check correct usage. */
 int prologue(int argc, char *argv[]) {
 	fprintf(stderr, "=== Vector Calculator Interpreter. \n");
 	fprintf(stderr, "(c) Grigory Goltsov, January 2012. \n\n");
 	if(argc<2 || argc>3)
     {
-		fprintf(stderr, "invalid usage: vectorCalc <script-file> {<dataset-file>}\n");
+		fprintf(stderr, "invalid usage: vectorCalc {--tree | --linear | --quicken | --vm | --closure | --jit | --compile} {--whole-script} {--no-optimise} <script-file> {<dataset-file>}\n");
 		return 0;
 	}
     else
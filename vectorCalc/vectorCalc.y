@@ -1,7 +1,7 @@
 /*
    Vector Calculator Interpreter
    This is quite a complex vector calculator, which lets the user
-   try out various calculations with 2- and 3-dimensional vectors.
+   try out various calculations with 2-, 3- and 4-dimensional vectors.
    The language incorporates controls constructs such as if-else and 
    while. The output can be specified to be both stdout and a file.
   
@@ -10,12 +10,31 @@
        - a parse tree that is populated by the interpreter and is then
          traversed in Depth-First Search manner - the same way it is
          populated during parsing;
+       - static type checking - every statement is type-checked before it
+         is executed, and the tree walker runs operators specialised for
+         the types of their operands;
+       - 64-bit int variables with exact arithmetic and comparisons, for
+         loop counters and indices; a whole-number constant next to an
+         int is an int, and an int meeting a number becomes a number;
+       - vector[] and number[] arrays, created with vector[n] and
+         number[n] and indexed by ints; the arithmetic operators, >< and
+         . apply to whole arrays at once, a vector or number operand
+         taking part with every element;
+       - vec2 and vec4 vectors next to vector (also called vec3), written
+         {x, y} and {x, y, z, w}; each only stores and computes the
+         components it has;
+       - each statement is compiled into bytecode for a stack-based
+         virtual machine; the tree traversal is kept as the reference
+         implementation (--tree);
+       - the whole script can be translated into C and run as a cached
+         shared object (--compile), or parsed and optimised as one
+         program before it is run (--whole-script);
        - 2-character operators, such as <=, ==, !=;
        - variables are possible to define on-the-fly, to emphasise the
          scripting nature of this little language (that is mostly
          intended for quick computations and demonstrations);
-       - memory managment - parse tree nodes actually get free'd when
-         evaluated (via freeNode());
+       - memory managment - parse tree nodes are allocated from an arena
+         that is reset once the statement is evaluated (via freeNodes());
        - check for "Out of memory" errors.
  */
 
@@ -33,9 +52,13 @@
     /* prototypes */
     nodeType* operator(int oper, int nops, ...);
     nodeType* id(int i, char*);
-    nodeType* constantNum(double);
-    nodeType* constantVec(double, double, double);
-    void freeNode(nodeType*);
+    nodeType* constantNum(real);
+    nodeType* constantWhole(int64);
+    nodeType* constantVec(real, real, real);
+    nodeType* constantVec2(real, real);
+    nodeType* constantVec4(real, real, real, real);
+    nodeType* sequence(nodeType*, nodeType*);
+    void freeNodes(void);
 
     char* getTypeAsString(int);
 
@@ -50,22 +73,41 @@
 %}
 
 %union {
-    double numberVal;       /* number value */
+    real numberVal;         /* number value */
+    int64 integerVal;       /* int literal value */
     char* id;               /* variable name */
     int type;               /* variable type */
     nodeType* nodePtr;      /* node pointer */
 };
 
 %token <numberVal> NUMBER
+%token <integerVal> INTEGER
 %token <id> IDENTIFIER
 
 %token WHILE IF
 %token PRINT
+%token SEQUENCE         /* a block - its statements are the operands */
+%token LINE             /* the line of a kept statement, in the linear tree */
 
-%token tVECTOR tNUMBER
+%token tVECTOR tNUMBER tINT tVEC2 tVEC4
 
 %token GE LE EQ NE
 %token CROSS DOT
+
+/* the specialised operators, which the type checker rewrites the generic
+   ones into once the types of their operands are known */
+%token NUM_NEG VEC_NEG NUM_ADD VEC_ADD NUM_SUB VEC_SUB
+%token NUM_MUL VEC_SCALE SCALE_VEC NUM_DIV VEC_DIV DIV_VEC
+%token VEC_CROSS VEC_DOT NUM_LT NUM_GT NUM_GE NUM_LE
+%token NUM_EQ VEC_EQ NUM_NE VEC_NE
+%token NUM_ASSIGN VEC_ASSIGN NUM_PRINT VEC_PRINT
+%token INT_NEG INT_ADD INT_SUB INT_MUL INT_DIV
+%token INT_LT INT_GT INT_GE INT_LE INT_EQ INT_NE
+%token INT_ASSIGN INT_PRINT
+/* an int used as a number, made explicit by the type checker */
+%token TO_NUMBER
+/* a new array - vector[n] or number[n] - and its elements */
+%token VEC_ARRAY NUM_ARRAY INDEX INDEX_ASSIGN
 /* here the implied non-associativity is used to solve the
    shift-reduce conflict in if-else ambiguity. It essentially gives
    an IF-ELSE statement a higher precedence than a simple IF
@@ -73,6 +115,9 @@
 %nonassoc IFX
 %nonassoc ELSE
 
+/* an assignment takes the whole expression to its right, so '=' has
+   the lowest precedence of the operators. */
+%right '='
 %left '<' '>' GE LE EQ NE 
 %left '+' '-'
 %left '*' '/'
@@ -83,22 +128,25 @@
 %type <nodePtr> statement
 %type <nodePtr> statementList
 %type <nodePtr> expression
+%type <numberVal> component
 %type <type>    type
 
-%expect 18
+/* the only expected conflicts: at the start of each of the six places
+   a statement can begin, an IDENTIFIER could be the name of an untyped
+   declaration (the empty type) or start an expression. The shift is
+   taken, so the empty type is never used and a plain 'a = b;' parses as
+   an assignment expression. */
+%expect 6
 
 %%
 
 script:
-          function              { exit(0); }
+          function              { executeScript(); exit(0); }
         ;
 
 function:
           function statement    { if(errorCount == 0)
-                                  {
-                                      interpret($2);
-                                      freeNode($2);
-                                  }
+                                      execute($2);
                                 }
         |
         ;
@@ -119,25 +167,47 @@ statement:
         ;
 
 statementList:
-          statement             { $$ = $1; }
+          statement             { $$ = sequence(NULL, $1); }
         | statementList statement
-                                { $$ = operator(';', 2, $1, $2); }  
+                                { $$ = sequence($1, $2); }
         ;
 
 type:
         | tVECTOR               { $$ = typeVecConstant; }
         | tNUMBER               { $$ = typeNumConstant; }
+        | tINT                  { $$ = typeIntConstant; }
+        | tVEC2                 { $$ = typeVec2Constant; }
+        | tVEC4                 { $$ = typeVec4Constant; }
+        | tVECTOR '[' ']'       { $$ = typeVecArray; }
+        | tNUMBER '[' ']'       { $$ = typeNumArray; }
         ;
 
 expression:
           NUMBER                { $$ = constantNum($1); }
+        | INTEGER               { $$ = constantWhole($1); }
         | IDENTIFIER            { if(!isDeclared($1))
 		                              semanticError(2, $1);
 	                              $$ = id(-1, $1); }
         | IDENTIFIER '=' expression
                                 { $$ = operator('=', 2, id(-1, $1), $3); }
-        | '{' NUMBER ',' NUMBER ',' NUMBER '}'
+        | IDENTIFIER '[' expression ']'
+                                { if(!isDeclared($1))
+		                              semanticError(2, $1);
+	                              $$ = operator(INDEX, 2, id(-1, $1), $3); }
+        | IDENTIFIER '[' expression ']' '=' expression
+                                { if(!isDeclared($1))
+		                              semanticError(2, $1);
+	                              $$ = operator(INDEX_ASSIGN, 3, id(-1, $1), $3, $6); }
+        | tVECTOR '[' expression ']'
+                                { $$ = operator(VEC_ARRAY, 1, $3); }
+        | tNUMBER '[' expression ']'
+                                { $$ = operator(NUM_ARRAY, 1, $3); }
+        | '{' component ',' component ',' component '}'
                                 { $$ = constantVec($2, $4, $6); }
+        | '{' component ',' component '}'
+                                { $$ = constantVec2($2, $4); }
+        | '{' component ',' component ',' component ',' component '}'
+                                { $$ = constantVec4($2, $4, $6, $8); }
         | '-' expression %prec UMINUS
                                 { $$ = operator(UMINUS, 1, $2); }
         | expression '+' expression
@@ -167,6 +237,12 @@ expression:
         | '(' expression ')'    { $$ = $2; }
         ;
 
+/* a component of a vector constant */
+component:
+          NUMBER                { $$ = $1; }
+        | INTEGER               { $$ = (real)$1; }
+        ;
+
 %%
 
 void yyerror(char *msg) {